@@ -0,0 +1,447 @@
+#include "async_client.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const int TICK_MS = 20; // resolución de plazos y reintentos de conexión
+
+// Campo `index` de una respuesta "A|B|C..."; con toEnd incluye el resto de la línea
+std::string_view field(std::string_view line, int index, bool toEnd = false) {
+    size_t start = 0;
+    for (int i = 0; i < index; i++) {
+        start = line.find('|', start);
+        if (start == std::string_view::npos) {
+            return std::string_view();
+        }
+        start++;
+    }
+    size_t end = toEnd ? std::string_view::npos : line.find('|', start);
+    return line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+}
+
+} // namespace
+
+AsyncTransactionClient::AsyncTransactionClient(const Options& options, const std::string& aesKey,
+                                               const std::string& secretKey)
+    : options(options), aesKey(aesKey), secretKey(secretKey), encoder(aesKey, secretKey),
+      state(State::Disconnected), socketFd(-1), epollFd(-1), wakeFd(-1), interest(0),
+      writeOffset(0), backoff(options.reconnectDelay), running(false), pendingCount(0) {
+    if (this->options.maxInFlight == 0) {
+        this->options.maxInFlight = 1;
+    }
+}
+
+AsyncTransactionClient::~AsyncTransactionClient() {
+    stop();
+}
+
+bool AsyncTransactionClient::start() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        std::cerr << "[ERROR] No se pudo crear el bucle de eventos: " << strerror(errno) << std::endl;
+        return false;
+    }
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    running = true;
+    nextConnectAttempt = std::chrono::steady_clock::now();
+    worker = std::thread(&AsyncTransactionClient::loop, this);
+    return true;
+}
+
+void AsyncTransactionClient::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    wake();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (socketFd >= 0) {
+        close(socketFd);
+        socketFd = -1;
+    }
+    close(epollFd);
+    close(wakeFd);
+    epollFd = wakeFd = -1;
+
+    failAll(inFlight, AsyncResponse::Status::Disconnected, "Cliente detenido");
+    failAll(waiting, AsyncResponse::Status::Disconnected, "Cliente detenido");
+    std::deque<Request> remaining;
+    {
+        std::lock_guard<std::mutex> lock(submitMutex);
+        remaining.swap(submitted);
+    }
+    failAll(remaining, AsyncResponse::Status::Disconnected, "Cliente detenido");
+}
+
+void AsyncTransactionClient::submit(const Transaction& transaction, Callback callback) {
+    Request request;
+    request.id = transaction.id;
+    transaction.serializeTo(request.plaintext);
+    request.callback = std::move(callback);
+    request.deadline = std::chrono::steady_clock::now() + options.timeout;
+
+    if (!running) {
+        pendingCount++;
+        complete(request, AsyncResponse::Status::Disconnected, std::string_view(), "Cliente detenido");
+        return;
+    }
+
+    pendingCount++;
+    {
+        std::lock_guard<std::mutex> lock(submitMutex);
+        submitted.push_back(std::move(request));
+    }
+    wake();
+}
+
+std::future<AsyncResponse> AsyncTransactionClient::submit(const Transaction& transaction) {
+    auto promise = std::make_shared<std::promise<AsyncResponse>>();
+    std::future<AsyncResponse> result = promise->get_future();
+    submit(transaction, [promise](const AsyncResponse& response) {
+        promise->set_value(response);
+    });
+    return result;
+}
+
+void AsyncTransactionClient::wake() {
+    uint64_t one = 1;
+    if (wakeFd >= 0) {
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void AsyncTransactionClient::loop() {
+    struct epoll_event events[8];
+
+    while (running) {
+        auto now = std::chrono::steady_clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock(submitMutex);
+            while (!submitted.empty()) {
+                waiting.push_back(std::move(submitted.front()));
+                submitted.pop_front();
+            }
+        }
+
+        if (state == State::Disconnected && now >= nextConnectAttempt) {
+            beginConnect();
+        }
+        if (state == State::Ready) {
+            fillWindow();
+        }
+        if (socketFd >= 0 && state != State::Connecting && writeOffset < writeBuffer.size() && !flushWrites()) {
+            continue;
+        }
+        updateInterest();
+
+        int count = epoll_wait(epollFd, events, 8, TICK_MS);
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.fd == wakeFd) {
+                uint64_t value;
+                while (read(wakeFd, &value, sizeof(value)) > 0) {
+                }
+                continue;
+            }
+            if (socketFd < 0 || events[i].data.fd != socketFd) {
+                continue;
+            }
+
+            uint32_t flags = events[i].events;
+            if (state == State::Connecting) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                getsockopt(socketFd, SOL_SOCKET, SO_ERROR, &error, &length);
+                if (error != 0 || (flags & (EPOLLERR | EPOLLHUP))) {
+                    dropConnection(error ? strerror(error) : "conexión rechazada");
+                    continue;
+                }
+                onConnected();
+                continue;
+            }
+            if ((flags & EPOLLIN) && !readResponses()) {
+                continue;
+            }
+            if ((flags & EPOLLOUT) && !flushWrites()) {
+                continue;
+            }
+            if ((flags & (EPOLLERR | EPOLLHUP)) && !(flags & EPOLLIN)) {
+                dropConnection("error de socket");
+            }
+        }
+
+        expireRequests(std::chrono::steady_clock::now());
+    }
+}
+
+void AsyncTransactionClient::beginConnect() {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    std::string port = std::to_string(options.port);
+    if (getaddrinfo(options.host.c_str(), port.c_str(), &hints, &result) != 0 || !result) {
+        dropConnection("no se pudo resolver el host");
+        return;
+    }
+
+    socketFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (socketFd < 0) {
+        freeaddrinfo(result);
+        dropConnection("no se pudo crear el socket");
+        return;
+    }
+    int noDelay = 1;
+    setsockopt(socketFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    int rc = connect(socketFd, result->ai_addr, result->ai_addrlen);
+    freeaddrinfo(result);
+    if (rc < 0 && errno != EINPROGRESS) {
+        dropConnection(strerror(errno));
+        return;
+    }
+
+    struct epoll_event event = {};
+    event.events = EPOLLOUT;
+    event.data.fd = socketFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, socketFd, &event);
+    interest = EPOLLOUT;
+    state = State::Connecting;
+}
+
+void AsyncTransactionClient::onConnected() {
+    reader.reset(socketFd);
+    writeBuffer.clear();
+    writeOffset = 0;
+
+    if (!options.useSession) {
+        state = State::Ready;
+        backoff = options.reconnectDelay;
+        std::cout << "[SUCCESS] Cliente asíncrono conectado a " << options.host << ":" << options.port << std::endl;
+        return;
+    }
+
+    // Primer mensaje de la conexión: el handshake de sesión
+    if (!CryptoUtils::fillRandomBytes(clientNonce, sizeof(clientNonce))) {
+        dropConnection("no se pudo generar el nonce de sesión");
+        return;
+    }
+    char nonceChars[24];
+    clientNonceText.assign(nonceChars, CryptoUtils::base64Encode(clientNonce, sizeof(clientNonce), nonceChars));
+    writeBuffer.append("HELLO|").append(clientNonceText).push_back('|');
+    writeBuffer.append(SecureSession::helloTag(secretKey, clientNonceText)).push_back('\n');
+    state = State::Handshaking;
+}
+
+bool AsyncTransactionClient::completeHandshake(std::string_view line) {
+    std::string_view serverNonce = field(line, 1);
+    std::string_view serverTag = field(line, 2);
+    if (field(line, 0) != "SESSION" ||
+        !CryptoUtils::verifyHMAC({"SESSION|", clientNonceText, "|", serverNonce}, serverTag, secretKey)) {
+        dropConnection("handshake de sesión rechazado");
+        return false;
+    }
+    std::vector<unsigned char> serverBytes = CryptoUtils::base64Decode(serverNonce);
+    if (serverBytes.size() != SecureSession::HANDSHAKE_NONCE_LENGTH ||
+        !session.establish(secretKey, aesKey, clientNonce, serverBytes.data())) {
+        dropConnection("handshake de sesión inválido");
+        return false;
+    }
+
+    state = State::Ready;
+    backoff = options.reconnectDelay;
+    std::cout << "[SUCCESS] Cliente asíncrono conectado con sesión segura a " << options.host << ":"
+              << options.port << std::endl;
+    return true;
+}
+
+void AsyncTransactionClient::dropConnection(const char* reason) {
+    if (socketFd >= 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, socketFd, nullptr);
+        close(socketFd);
+        socketFd = -1;
+    }
+    if (state != State::Disconnected || !inFlight.empty()) {
+        std::cerr << "[WARNING] Conexión del cliente asíncrono perdida: " << reason
+                  << "; reintento en " << backoff.count() << " ms" << std::endl;
+    }
+    state = State::Disconnected;
+    interest = 0;
+    reader.reset(-1);
+    writeBuffer.clear();
+    writeOffset = 0;
+
+    failAll(inFlight, AsyncResponse::Status::Disconnected, reason);
+
+    nextConnectAttempt = std::chrono::steady_clock::now() + backoff;
+    backoff = std::min(backoff * 2, options.maxReconnectDelay);
+}
+
+// Cifra y agrega al búfer de salida las transacciones en espera que caben en la ventana
+void AsyncTransactionClient::fillWindow() {
+    while (!waiting.empty() && inFlight.size() < options.maxInFlight) {
+        Request& request = waiting.front();
+        encoder.beginPlaintext().append(request.plaintext);
+        if (!encoder.finish(options.useSession ? &session : nullptr)) {
+            Request failed = std::move(request);
+            waiting.pop_front();
+            complete(failed, AsyncResponse::Status::Error, std::string_view(), "Error al cifrar la transacción");
+            continue;
+        }
+        writeBuffer.append(encoder.wire());
+        inFlight.push_back(std::move(request));
+        waiting.pop_front();
+    }
+}
+
+bool AsyncTransactionClient::flushWrites() {
+    while (writeOffset < writeBuffer.size()) {
+        ssize_t sent = send(socketFd, writeBuffer.data() + writeOffset, writeBuffer.size() - writeOffset,
+                            MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            dropConnection(strerror(errno));
+            return false;
+        }
+        writeOffset += static_cast<size_t>(sent);
+    }
+    writeBuffer.clear();
+    writeOffset = 0;
+    return true;
+}
+
+bool AsyncTransactionClient::readResponses() {
+    std::string_view line;
+    while (true) {
+        switch (reader.next(line)) {
+        case FrameReader::Status::Frame:
+            if (!handleLine(line)) {
+                return false;
+            }
+            break;
+        case FrameReader::Status::Again:
+            return true;
+        case FrameReader::Status::Closed:
+            dropConnection("el servidor cerró la conexión");
+            return false;
+        case FrameReader::Status::TooLarge:
+            dropConnection("respuesta demasiado grande");
+            return false;
+        case FrameReader::Status::Error:
+            dropConnection(strerror(errno));
+            return false;
+        }
+    }
+}
+
+bool AsyncTransactionClient::handleLine(std::string_view line) {
+    if (state == State::Handshaking) {
+        return completeHandshake(line);
+    }
+
+    std::string_view status = field(line, 0);
+    if (status == "SUCCESS") {
+        std::string_view id = field(line, 2);
+        for (auto it = inFlight.begin(); it != inFlight.end(); ++it) {
+            if (it->id == id) {
+                Request request = std::move(*it);
+                inFlight.erase(it);
+                complete(request, AsyncResponse::Status::Success, line, std::string(field(line, 3, true)));
+                return true;
+            }
+        }
+        std::cerr << "[WARNING] Respuesta para una transacción desconocida: " << id << std::endl;
+        return true;
+    }
+
+    if (inFlight.empty()) {
+        std::cerr << "[WARNING] Respuesta sin transacción pendiente: " << line << std::endl;
+        return true;
+    }
+    Request request = std::move(inFlight.front());
+    inFlight.pop_front();
+    complete(request, AsyncResponse::Status::Error, line, std::string(field(line, 2)));
+    return true;
+}
+
+void AsyncTransactionClient::expireRequests(std::chrono::steady_clock::time_point now) {
+    // Las que no se enviaron pueden vencer sin afectar la conexión
+    for (auto it = waiting.begin(); it != waiting.end();) {
+        if (now > it->deadline) {
+            Request request = std::move(*it);
+            it = waiting.erase(it);
+            complete(request, AsyncResponse::Status::Timeout, std::string_view(), "Plazo vencido antes de enviar");
+        } else {
+            ++it;
+        }
+    }
+
+    // Una enviada sin respuesta rompe la correlación por orden: se descarta la conexión
+    if (!inFlight.empty() && now > inFlight.front().deadline) {
+        Request request = std::move(inFlight.front());
+        inFlight.pop_front();
+        complete(request, AsyncResponse::Status::Timeout, std::string_view(), "Sin respuesta del servidor");
+        dropConnection("plazo de respuesta vencido");
+    }
+}
+
+void AsyncTransactionClient::updateInterest() {
+    if (socketFd < 0 || state == State::Connecting) {
+        return;
+    }
+    uint32_t wanted = EPOLLIN;
+    if (writeOffset < writeBuffer.size()) {
+        wanted |= EPOLLOUT;
+    }
+    if (wanted != interest) {
+        struct epoll_event event = {};
+        event.events = wanted;
+        event.data.fd = socketFd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, socketFd, &event);
+        interest = wanted;
+    }
+}
+
+void AsyncTransactionClient::complete(Request& request, AsyncResponse::Status status, std::string_view line,
+                                      std::string detail) {
+    AsyncResponse response;
+    response.status = status;
+    response.transactionId = std::move(request.id);
+    response.line.assign(line.data(), line.size());
+    response.detail = std::move(detail);
+    pendingCount--;
+    if (request.callback) {
+        request.callback(response);
+    }
+}
+
+void AsyncTransactionClient::failAll(std::deque<Request>& requests, AsyncResponse::Status status,
+                                     const char* detail) {
+    while (!requests.empty()) {
+        Request request = std::move(requests.front());
+        requests.pop_front();
+        complete(request, status, std::string_view(), detail);
+    }
+}
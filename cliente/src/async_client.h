@@ -0,0 +1,127 @@
+#ifndef ASYNC_CLIENT_H
+#define ASYNC_CLIENT_H
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <chrono>
+#include <functional>
+#include "crypto_utils.h"
+#include "message_encoder.h"
+#include "frame_io.h"
+
+// Resultado de una transacción enviada por el cliente asíncrono
+struct AsyncResponse {
+    enum class Status {
+        Success,      // SUCCESS|...
+        Error,        // ERROR|... (rechazada por el servidor)
+        Timeout,      // sin respuesta dentro del plazo
+        Disconnected  // la conexión se perdió o el cliente se detuvo antes de responder
+    };
+
+    Status status = Status::Disconnected;
+    std::string transactionId;
+    std::string line;   // respuesta completa del servidor, sin el terminador
+    std::string detail; // resultado, motivo del error o del fallo local
+};
+
+// Cliente asíncrono sobre una sola conexión persistente. Un hilo con epoll escribe
+// las transacciones encoladas sin esperar respuesta, hasta `maxInFlight` pendientes,
+// y reparte las respuestas: las SUCCESS por ID de transacción y las ERROR (que no
+// llevan ID) a la más antigua pendiente, ya que el servidor responde en orden.
+//
+// Si la conexión se cae se reconecta con espera exponencial. Las transacciones ya
+// enviadas se completan como Disconnected y no se reenvían: pudieron ejecutarse.
+// Si una transacción enviada vence su plazo se descarta la conexión, porque las
+// respuestas posteriores ya no podrían correlacionarse por orden.
+class AsyncTransactionClient {
+public:
+    struct Options {
+        std::string host = "127.0.0.1";
+        int port = 8080;
+        size_t maxInFlight = 64;
+        std::chrono::milliseconds timeout{5000};
+        std::chrono::milliseconds reconnectDelay{100};
+        std::chrono::milliseconds maxReconnectDelay{5000};
+        bool useSession = false; // negociar clave de sesión en cada conexión
+    };
+
+    // Se invoca en el hilo del cliente: no debe bloquear
+    using Callback = std::function<void(const AsyncResponse&)>;
+
+    AsyncTransactionClient(const Options& options, const std::string& aesKey, const std::string& secretKey);
+    ~AsyncTransactionClient();
+
+    AsyncTransactionClient(const AsyncTransactionClient&) = delete;
+    AsyncTransactionClient& operator=(const AsyncTransactionClient&) = delete;
+
+    bool start();
+    // Detiene el hilo; lo que quede pendiente se completa como Disconnected
+    void stop();
+
+    void submit(const Transaction& transaction, Callback callback);
+    std::future<AsyncResponse> submit(const Transaction& transaction);
+
+    size_t pending() const { return pendingCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Request {
+        std::string id;
+        std::string plaintext;
+        Callback callback;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    enum class State { Disconnected, Connecting, Handshaking, Ready };
+
+    void loop();
+    void beginConnect();
+    void onConnected();
+    void dropConnection(const char* reason);
+    void fillWindow();
+    bool flushWrites();
+    bool readResponses();
+    bool handleLine(std::string_view line);
+    bool completeHandshake(std::string_view line);
+    void expireRequests(std::chrono::steady_clock::time_point now);
+    void updateInterest();
+    void complete(Request& request, AsyncResponse::Status status, std::string_view line, std::string detail);
+    void failAll(std::deque<Request>& requests, AsyncResponse::Status status, const char* detail);
+    void wake();
+
+    Options options;
+    std::string aesKey;
+    std::string secretKey;
+    MessageEncoder encoder;
+
+    // Entrada desde otros hilos
+    std::mutex submitMutex;
+    std::deque<Request> submitted;
+
+    // Solo del hilo del cliente
+    std::deque<Request> waiting;  // aún no enviadas
+    std::deque<Request> inFlight; // enviadas, en el orden de envío
+    State state;
+    int socketFd;
+    int epollFd;
+    int wakeFd;
+    uint32_t interest;
+    SecureSession session;
+    unsigned char clientNonce[SecureSession::HANDSHAKE_NONCE_LENGTH];
+    std::string clientNonceText;
+    FrameReader reader;
+    std::string writeBuffer;
+    size_t writeOffset;
+    std::chrono::milliseconds backoff;
+    std::chrono::steady_clock::time_point nextConnectAttempt;
+
+    std::thread worker;
+    std::atomic<bool> running;
+    std::atomic<size_t> pendingCount;
+};
+
+#endif // ASYNC_CLIENT_H
@@ -2,12 +2,53 @@
 #include <string>
 #include <sstream>
 #include <cstdlib>
+#include <fstream>
+#include <vector>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <unistd.h>
 #include <cstring>
+#include <memory>
+#include <chrono>
 #include "crypto_utils.h"
+#include "message_encoder.h"
+#include "async_client.h"
+#include "frame_io.h"
+
+// Lote de transacciones enviado bajo un único IV/HMAC/token
+struct TransactionBatch {
+    std::string id;
+    std::string timestamp;
+    std::string mode; // ATOMIC o PARTIAL
+    std::string dynamicToken;
+    std::vector<Transaction> items;
+};
+
+// Comandos que generan una transacción; la misma sintaxis vale en la línea de
+// comandos y en cada línea de un archivo de lote
+struct TransactionCommand {
+    std::string_view name;
+    TransactionType type;
+    size_t arguments;
+    const char* usage;
+};
+
+constexpr TransactionCommand TRANSACTION_COMMANDS[] = {
+    {"transfer", TransactionType::Transfer, 3, "<monto> <cuenta_origen> <cuenta_destino>"},
+    {"balance", TransactionType::Balance, 1, "<cuenta>"},
+    {"payment", TransactionType::Payment, 3, "<monto> <cuenta_origen> <codigo_servicio>"},
+    {"deposit", TransactionType::Deposit, 2, "<monto> <cuenta_destino>"},
+};
+
+const TransactionCommand* findTransactionCommand(std::string_view name) {
+    for (const TransactionCommand& command : TRANSACTION_COMMANDS) {
+        if (command.name == name) {
+            return &command;
+        }
+    }
+    return nullptr;
+}
 
 class TransactionClient {
 private:
@@ -15,6 +56,17 @@ private:
     int serverPort;
     std::string secretKey;
     std::string aesKey;
+    bool timeOrderedIds;
+    bool useSession;
+    // Búferes y contextos de cifrado reutilizados por todos los mensajes del cliente
+    std::unique_ptr<MessageEncoder> encoder;
+    // Lector de respuestas; su búfer se reutiliza entre conexiones
+    FrameReader responseReader;
+
+    // UUID_VERSION=7 genera IDs ordenados por tiempo, con mejor localidad en índices de historial
+    std::string newTransactionId() const {
+        return timeOrderedIds ? CryptoUtils::generateUUIDv7() : CryptoUtils::generateUUID();
+    }
 
 public:
     TransactionClient(const std::string& host = "127.0.0.1", int port = 8080) 
@@ -36,6 +88,15 @@ public:
             aesKey = "mi_clave_aes_256_bits_muy_segura"; // Exactamente 32 caracteres
         }
         
+        const char* envUuidVersion = std::getenv("UUID_VERSION");
+        timeOrderedIds = envUuidVersion && std::string(envUuidVersion) == "7";
+
+        // SESSION_KEYS=1 negocia una clave de sesión por conexión (AES-GCM + secuencia)
+        const char* envSession = std::getenv("SESSION_KEYS");
+        useSession = envSession && std::string(envSession) == "1";
+
+        encoder.reset(new MessageEncoder(aesKey, secretKey));
+        
         std::cout << "[INFO] Cliente inicializado" << std::endl;
         std::cout << "[INFO] Servidor destino: " << serverHost << ":" << serverPort << std::endl;
     }
@@ -43,9 +104,25 @@ public:
     bool sendTransaction(const Transaction& transaction) {
         std::cout << "\n=== ENVIANDO TRANSACCIÓN ===" << std::endl;
         std::cout << "[INFO] ID: " << transaction.id << std::endl;
-        std::cout << "[INFO] Tipo: " << transaction.type << std::endl;
+        std::cout << "[INFO] Tipo: " << transactionTypeName(transaction.type) << std::endl;
         std::cout << "[INFO] Monto: $" << transaction.amount << std::endl;
 
+        transaction.serializeTo(encoder->beginPlaintext());
+        return sendSecureMessage();
+    }
+
+    bool sendBatch(const TransactionBatch& batch) {
+        std::cout << "\n=== ENVIANDO LOTE ===" << std::endl;
+        std::cout << "[INFO] ID Lote: " << batch.id << std::endl;
+        std::cout << "[INFO] Modo: " << batch.mode << std::endl;
+        std::cout << "[INFO] Transacciones: " << batch.items.size() << std::endl;
+
+        serializeBatchTo(batch, encoder->beginPlaintext());
+        return sendSecureMessage();
+    }
+
+    // Cifra y envía el texto plano que quedó en el encoder
+    bool sendSecureMessage() {
         // Crear socket
         int clientSocket = socket(AF_INET, SOCK_STREAM, 0);
         if (clientSocket < 0) {
@@ -81,89 +158,166 @@ public:
         }
 
         std::cout << "[SUCCESS] Conexión establecida con el servidor" << std::endl;
+        responseReader.reset(clientSocket);
 
-        // Preparar y enviar transacción
-        std::string encryptedMessage = prepareSecureMessage(transaction);
-        if (encryptedMessage.empty()) {
+        // Preparar y enviar mensaje
+        SecureSession session;
+        if (useSession && !establishSession(clientSocket, session)) {
+            std::cerr << "[ERROR] No se pudo establecer la sesión segura" << std::endl;
+            close(clientSocket);
+            return false;
+        }
+        if (!encoder->finish(useSession ? &session : nullptr)) {
             std::cerr << "[ERROR] Error al preparar mensaje seguro" << std::endl;
             close(clientSocket);
             return false;
         }
 
-        encryptedMessage += "\n"; // Terminador de mensaje
-        
-        std::cout << "[INFO] Enviando transacción cifrada..." << std::endl;
-        if (send(clientSocket, encryptedMessage.c_str(), encryptedMessage.length(), 0) < 0) {
+        // El mensaje del encoder ya incluye el terminador '\n'
+        const std::string& encryptedMessage = encoder->wire();
+        std::cout << "[INFO] Enviando transacción cifrada (" << encryptedMessage.length() << " bytes)..." << std::endl;
+        if (!FrameWriter::sendAll(clientSocket, encryptedMessage)) {
             std::cerr << "[ERROR] Error al enviar datos al servidor" << std::endl;
             close(clientSocket);
             return false;
         }
 
-        // Recibir respuesta
-        char buffer[4096];
-        memset(buffer, 0, sizeof(buffer));
-        int bytesReceived = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
-        
-        if (bytesReceived <= 0) {
+        // Recibir respuesta: una línea completa, aunque llegue en varios segmentos
+        std::string_view response;
+        if (responseReader.next(response) != FrameReader::Status::Frame) {
             std::cerr << "[ERROR] No se recibió respuesta del servidor" << std::endl;
             close(clientSocket);
             return false;
         }
 
-        std::string response(buffer, bytesReceived);
-        processServerResponse(response);
+        processServerResponse(std::string(response));
 
         close(clientSocket);
         return true;
     }
 
-    std::string prepareSecureMessage(const Transaction& transaction) {
-        std::cout << "[INFO] Preparando mensaje seguro..." << std::endl;
+    // Cliente asíncrono hacia el mismo servidor, con las mismas claves y modo de sesión
+    std::unique_ptr<AsyncTransactionClient> connectAsync(size_t maxInFlight, std::chrono::milliseconds timeout) {
+        AsyncTransactionClient::Options options;
+        options.host = serverHost;
+        options.port = serverPort;
+        options.maxInFlight = maxInFlight;
+        options.timeout = timeout;
+        options.useSession = useSession;
+        std::unique_ptr<AsyncTransactionClient> async(new AsyncTransactionClient(options, aesKey, secretKey));
+        if (!async->start()) {
+            return nullptr;
+        }
+        return async;
+    }
+
+    // Envía `count` consultas de saldo por una sola conexión, sin esperar cada respuesta.
+    // ASYNC_WINDOW y ASYNC_TIMEOUT_MS ajustan la ventana de pendientes y el plazo.
+    bool runPipeline(size_t count, const std::string& account) {
+        const char* envWindow = std::getenv("ASYNC_WINDOW");
+        const char* envTimeout = std::getenv("ASYNC_TIMEOUT_MS");
+        size_t window = envWindow ? std::strtoul(envWindow, nullptr, 10) : 64;
+        std::chrono::milliseconds timeout(envTimeout ? std::atol(envTimeout) : 5000);
+
+        std::unique_ptr<AsyncTransactionClient> async = connectAsync(window, timeout);
+        if (!async) {
+            return false;
+        }
+
+        std::vector<Transaction> transactions;
+        transactions.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            transactions.push_back(createBalanceTransaction(account));
+        }
 
-        // Serializar transacción
-        std::string transactionData = transaction.serialize();
-        std::cout << "[DEBUG] Datos de transacción serializados: " << transactionData.length() << " bytes" << std::endl;
+        std::cout << "\n=== ENVIANDO " << count << " TRANSACCIONES (ventana " << window << ") ===" << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::future<AsyncResponse>> responses;
+        responses.reserve(count);
+        for (const auto& t : transactions) {
+            responses.push_back(async->submit(t));
+        }
 
-        // Generar IV aleatorio para AES (exactamente 16 bytes)
-        std::string iv = CryptoUtils::generateRandomBytes(16);
-        if (iv.length() != 16) {
-            std::cerr << "[ERROR] Error al generar IV (tamaño: " << iv.length() << ")" << std::endl;
-            return "";
+        size_t byStatus[4] = {0, 0, 0, 0};
+        std::string lastError;
+        for (auto& future : responses) {
+            AsyncResponse response = future.get();
+            byStatus[static_cast<int>(response.status)]++;
+            if (response.status != AsyncResponse::Status::Success) {
+                lastError = response.detail;
+            }
         }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        async->stop();
+
+        std::cout << "\n=== RESULTADO DEL PIPELINE ===" << std::endl;
+        std::cout << "[INFO] Exitosas: " << byStatus[0] << ", rechazadas: " << byStatus[1]
+                  << ", sin respuesta: " << byStatus[2] << ", desconectadas: " << byStatus[3] << std::endl;
+        if (!lastError.empty()) {
+            std::cout << "[INFO] Último error: " << lastError << std::endl;
+        }
+        std::cout << "[INFO] Tiempo total: " << elapsed << " ms" << std::endl;
+        std::cout << "==============================\n" << std::endl;
+        return byStatus[0] == count;
+    }
 
-        // Verificar que la clave AES sea de 32 bytes
-        if (aesKey.length() != 32) {
-            std::cerr << "[ERROR] Clave AES debe ser de 32 bytes, actual: " << aesKey.length() << std::endl;
-            return "";
+    // Handshake: envía un nonce propio autenticado con la clave secreta, verifica el
+    // nonce del servidor y deriva la clave de sesión de ambos
+    bool establishSession(int clientSocket, SecureSession& session) {
+        unsigned char clientBytes[SecureSession::HANDSHAKE_NONCE_LENGTH];
+        if (!CryptoUtils::fillRandomBytes(clientBytes, sizeof(clientBytes))) {
+            return false;
         }
+        char clientChars[24];
+        std::string clientNonce(clientChars, CryptoUtils::base64Encode(clientBytes, sizeof(clientBytes), clientChars));
 
-        // Cifrar datos con AES-256
-        std::cout << "[INFO] Cifrando datos con AES-256..." << std::endl;
-        std::string encryptedData = CryptoUtils::encryptAES256(transactionData, aesKey, iv);
-        if (encryptedData.empty()) {
-            std::cerr << "[ERROR] Error al cifrar datos" << std::endl;
-            return "";
+        std::string hello = "HELLO|" + clientNonce + "|" + SecureSession::helloTag(secretKey, clientNonce) + "\n";
+        std::cout << "[INFO] Negociando clave de sesión..." << std::endl;
+        if (!FrameWriter::sendAll(clientSocket, hello)) {
+            return false;
         }
 
-        // Convertir IV a base64 para transmisión
-        std::vector<unsigned char> ivBytes(iv.begin(), iv.end());
-        std::string ivBase64 = CryptoUtils::base64Encode(ivBytes);
+        std::string_view frame;
+        if (responseReader.next(frame) != FrameReader::Status::Frame) {
+            return false;
+        }
 
-        // Crear HMAC para verificación de integridad
-        std::string dataToSign = ivBase64 + ":" + encryptedData;
-        std::string hmac = CryptoUtils::generateHMAC(dataToSign, secretKey);
-        if (hmac.empty()) {
-            std::cerr << "[ERROR] Error al generar HMAC" << std::endl;
-            return "";
+        // Respuesta esperada: SESSION|<nonce_servidor>|<hmac>
+        std::string reply(frame);
+        size_t first = reply.find('|');
+        size_t second = reply.find('|', first + 1);
+        if (reply.compare(0, 8, "SESSION|") != 0 || second == std::string::npos) {
+            std::cerr << "[ERROR] Respuesta de handshake inválida: " << reply << std::endl;
+            return false;
+        }
+        std::string serverNonce = reply.substr(first + 1, second - first - 1);
+        std::string serverTag = reply.substr(second + 1);
+        if (!CryptoUtils::verifyHMAC({"SESSION|", clientNonce, "|", serverNonce}, serverTag, secretKey)) {
+            std::cerr << "[ERROR] El servidor no pudo autenticarse en el handshake" << std::endl;
+            return false;
         }
 
-        std::cout << "[SUCCESS] Mensaje seguro preparado" << std::endl;
-        std::cout << "[DEBUG] IV Base64 length: " << ivBase64.length() << std::endl;
-        std::cout << "[DEBUG] Encrypted data length: " << encryptedData.length() << std::endl;
-        std::cout << "[DEBUG] HMAC length: " << hmac.length() << std::endl;
+        std::vector<unsigned char> serverBytes = CryptoUtils::base64Decode(serverNonce);
+        if (serverBytes.size() != SecureSession::HANDSHAKE_NONCE_LENGTH ||
+            !session.establish(secretKey, aesKey, clientBytes, serverBytes.data())) {
+            return false;
+        }
+        std::cout << "[SUCCESS] Sesión segura establecida" << std::endl;
+        return true;
+    }
 
-        // Formato final: IV:ENCRYPTED_DATA:HMAC
-        return ivBase64 + ":" + encryptedData + ":" + hmac;
+    // Encabezado y una transacción serializada por línea; el servidor valida el token una sola vez
+    void serializeBatchTo(const TransactionBatch& batch, std::string& out) {
+        out.append("BATCH|").append(batch.id).push_back('|');
+        out.append(batch.timestamp).push_back('|');
+        out.append(batch.mode).push_back('|');
+        out.append(std::to_string(batch.items.size())).push_back('|');
+        out.append(batch.dynamicToken);
+        for (const auto& item : batch.items) {
+            out.push_back('\n');
+            item.serializeTo(out);
+        }
     }
 
     void processServerResponse(const std::string& response) {
@@ -206,26 +360,43 @@ public:
         std::cout << "==============================\n" << std::endl;
     }
 
-    Transaction createTransferTransaction(double amount, const std::string& fromAccount, 
-                                        const std::string& toAccount) {
+    // Arma la transacción a partir de los argumentos del comando (sin el nombre);
+    // lanza std::invalid_argument si el monto no es un número
+    Transaction createTransaction(const TransactionCommand& command, const std::vector<std::string>& args) {
         Transaction t;
-        t.id = CryptoUtils::generateUUID();
+        t.id = newTransactionId();
         t.timestamp = CryptoUtils::getCurrentTimestamp();
-        t.type = "TRANSFER";
-        t.amount = amount;
-        t.accountFrom = fromAccount;
-        t.accountTo = toAccount;
-        t.dynamicToken = CryptoUtils::generateDynamicToken(secretKey, t.id);
-
-        std::cout << "[INFO] Token dinámico generado: " << t.dynamicToken.substr(0, 16) << "..." << std::endl;
+        t.type = command.type;
+        t.amount = 0.0;
+        switch (command.type) {
+        case TransactionType::Transfer:
+            t.amount = std::stod(args[0]);
+            t.accountFrom = args[1];
+            t.accountTo = args[2];
+            break;
+        case TransactionType::Balance:
+            t.accountFrom = args[0];
+            break;
+        case TransactionType::Payment:
+            t.amount = std::stod(args[0]);
+            t.accountFrom = args[1];
+            t.serviceCode = args[2];
+            break;
+        case TransactionType::Deposit:
+            t.amount = std::stod(args[0]);
+            t.accountTo = args[1];
+            break;
+        case TransactionType::Unknown:
+            break;
+        }
         return t;
     }
 
     Transaction createBalanceTransaction(const std::string& account) {
         Transaction t;
-        t.id = CryptoUtils::generateUUID();
+        t.id = newTransactionId();
         t.timestamp = CryptoUtils::getCurrentTimestamp();
-        t.type = "BALANCE";
+        t.type = TransactionType::Balance;
         t.amount = 0.0;
         t.accountFrom = account;
         t.dynamicToken = CryptoUtils::generateDynamicToken(secretKey, t.id);
@@ -234,35 +405,100 @@ public:
         return t;
     }
 
-    Transaction createPaymentTransaction(double amount, const std::string& fromAccount, 
-                                       const std::string& serviceCode) {
-        Transaction t;
-        t.id = CryptoUtils::generateUUID();
-        t.timestamp = CryptoUtils::getCurrentTimestamp();
-        t.type = "PAYMENT";
-        t.amount = amount;
-        t.accountFrom = fromAccount;
-        t.serviceCode = serviceCode;
+    // Transacción individual: lleva su propio token
+    Transaction createSignedTransaction(const TransactionCommand& command, const std::vector<std::string>& args) {
+        Transaction t = createTransaction(command, args);
         t.dynamicToken = CryptoUtils::generateDynamicToken(secretKey, t.id);
 
         std::cout << "[INFO] Token dinámico generado: " << t.dynamicToken.substr(0, 16) << "..." << std::endl;
         return t;
     }
 
-    Transaction createDepositTransaction(double amount, const std::string& toAccount) {
-        Transaction t;
-        t.id = CryptoUtils::generateUUID();
-        t.timestamp = CryptoUtils::getCurrentTimestamp();
-        t.type = "DEPOSIT";
-        t.amount = amount;
-        t.accountTo = toAccount;
-        t.dynamicToken = CryptoUtils::generateDynamicToken(secretKey, t.id);
+    // Las transacciones del lote no llevan token propio: el del lote las cubre a todas
+    TransactionBatch createBatch(const std::vector<Transaction>& items, bool atomic) {
+        TransactionBatch batch;
+        batch.id = newTransactionId();
+        batch.timestamp = CryptoUtils::getCurrentTimestamp();
+        batch.mode = atomic ? "ATOMIC" : "PARTIAL";
+        batch.items = items;
+        for (auto& item : batch.items) {
+            item.dynamicToken.clear();
+        }
+        batch.dynamicToken = CryptoUtils::generateDynamicToken(secretKey, batch.id);
 
-        std::cout << "[INFO] Token dinámico generado: " << t.dynamicToken.substr(0, 16) << "..." << std::endl;
-        return t;
+        std::cout << "[INFO] Token dinámico del lote generado: " << batch.dynamicToken.substr(0, 16) << "..." << std::endl;
+        return batch;
+    }
+
+    // Cada línea del archivo usa la misma sintaxis que los comandos individuales:
+    //   transfer <monto> <origen> <destino> | payment <monto> <origen> <servicio>
+    //   deposit <monto> <destino>           | balance <cuenta>
+    bool loadBatchFile(const std::string& path, std::vector<Transaction>& items) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "[ERROR] No se pudo abrir el archivo de lote: " << path << std::endl;
+            return false;
+        }
+
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line)) {
+            lineNumber++;
+            std::stringstream ss(line);
+            std::vector<std::string> args;
+            std::string arg;
+            while (ss >> arg) {
+                args.push_back(arg);
+            }
+            if (args.empty() || args[0][0] == '#') {
+                continue;
+            }
+
+            const TransactionCommand* command = findTransactionCommand(args[0]);
+            if (!command || args.size() != command->arguments + 1) {
+                std::cerr << "[ERROR] Línea " << lineNumber << " inválida: " << line << std::endl;
+                return false;
+            }
+            Transaction t;
+            try {
+                t = createTransaction(*command, std::vector<std::string>(args.begin() + 1, args.end()));
+            } catch (const std::exception&) {
+                std::cerr << "[ERROR] Monto inválido en la línea " << lineNumber << ": " << line << std::endl;
+                return false;
+            }
+            items.push_back(t);
+        }
+
+        if (items.empty()) {
+            std::cerr << "[ERROR] El archivo de lote no contiene transacciones" << std::endl;
+            return false;
+        }
+        return true;
     }
 };
 
+// Fecha de ejecución de "schedule": "+<segundos>" desde ahora o una fecha UTC
+// YYYY-MM-DDTHH:MM:SS[.mmm]Z. Devuelve el texto que viaja en la transacción.
+bool parseScheduleTime(const std::string& text, std::string& scheduledAt) {
+    int64_t millis;
+    if (!text.empty() && text[0] == '+') {
+        char* end = nullptr;
+        long long seconds = std::strtoll(text.c_str() + 1, &end, 10);
+        if (text.size() == 1 || *end != '\0' || seconds <= 0) {
+            return false;
+        }
+        millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count() + seconds * 1000;
+        scheduledAt = CryptoUtils::formatTimestampMillis(millis);
+        return true;
+    }
+    scheduledAt = text;
+    if (scheduledAt.size() == 20 && scheduledAt.back() == 'Z') {
+        scheduledAt.insert(19, ".000");
+    }
+    return CryptoUtils::parseTimestamp(scheduledAt, millis);
+}
+
 void printUsage(const char* programName) {
     std::cout << "\n=== CLIENTE DE TRANSACCIONES SEGURAS ===" << std::endl;
     std::cout << "Uso: " << programName << " <host> <puerto> <comando> [argumentos...]" << std::endl;
@@ -275,6 +511,15 @@ void printUsage(const char* programName) {
     std::cout << "    Ejemplo: " << programName << " 127.0.0.1 8080 payment 75.25 1234567890123456 EAAB001" << std::endl;
     std::cout << "  deposit <monto> <cuenta_destino>" << std::endl;
     std::cout << "    Ejemplo: " << programName << " 127.0.0.1 8080 deposit 200.00 1234567890123456" << std::endl;
+    std::cout << "  batch <archivo> [atomico|parcial]" << std::endl;
+    std::cout << "    Ejemplo: " << programName << " 127.0.0.1 8080 batch nomina.txt atomico" << std::endl;
+    std::cout << "    (una transacción por línea, con la sintaxis de los comandos anteriores)" << std::endl;
+    std::cout << "  schedule <fecha|+segundos> <transfer|payment> [argumentos...]" << std::endl;
+    std::cout << "    Ejemplo: " << programName << " 127.0.0.1 8080 schedule 2026-12-31T12:00:00Z payment 75.25 1234567890123456 EAAB001" << std::endl;
+    std::cout << "    (el servidor la ejecuta en la fecha indicada, en UTC)" << std::endl;
+    std::cout << "  pipeline <cantidad> <cuenta>" << std::endl;
+    std::cout << "    Ejemplo: " << programName << " 127.0.0.1 8080 pipeline 200 1234567890123456" << std::endl;
+    std::cout << "    (consultas de saldo concurrentes por una sola conexión asíncrona)" << std::endl;
     std::cout << "\nCuentas de prueba disponibles:" << std::endl;
     std::cout << "  - 1234567890123456 (Saldo inicial: $5000)" << std::endl;
     std::cout << "  - 6543210987654321 (Saldo inicial: $3000)" << std::endl;
@@ -294,54 +539,66 @@ int main(int argc, char* argv[]) {
 
     TransactionClient client(host, port);
 
-    if (command == "transfer") {
-        if (argc != 7) {
-            std::cerr << "[ERROR] Comando transfer requiere: <monto> <cuenta_origen> <cuenta_destino>" << std::endl;
+    if (const TransactionCommand* spec = findTransactionCommand(command)) {
+        if (static_cast<size_t>(argc) != spec->arguments + 4) {
+            std::cerr << "[ERROR] Comando " << command << " requiere: " << spec->usage << std::endl;
             return 1;
         }
-        
-        double amount = std::stod(argv[4]);
-        std::string fromAccount = argv[5];
-        std::string toAccount = argv[6];
-        
-        Transaction t = client.createTransferTransaction(amount, fromAccount, toAccount);
+
+        Transaction t = client.createSignedTransaction(*spec, std::vector<std::string>(argv + 4, argv + argc));
         client.sendTransaction(t);
-        
-    } else if (command == "balance") {
-        if (argc != 5) {
-            std::cerr << "[ERROR] Comando balance requiere: <cuenta>" << std::endl;
+
+    } else if (command == "batch") {
+        if (argc != 5 && argc != 6) {
+            std::cerr << "[ERROR] Comando batch requiere: <archivo> [atomico|parcial]" << std::endl;
             return 1;
         }
-        
-        std::string account = argv[4];
-        Transaction t = client.createBalanceTransaction(account);
-        client.sendTransaction(t);
-        
-    } else if (command == "payment") {
-        if (argc != 7) {
-            std::cerr << "[ERROR] Comando payment requiere: <monto> <cuenta_origen> <codigo_servicio>" << std::endl;
+
+        std::string mode = argc == 6 ? argv[5] : "atomico";
+        if (mode != "atomico" && mode != "parcial") {
+            std::cerr << "[ERROR] Modo de lote no reconocido: " << mode << std::endl;
             return 1;
         }
+
+        std::vector<Transaction> items;
+        if (!client.loadBatchFile(argv[4], items)) {
+            return 1;
+        }
+
+        TransactionBatch batch = client.createBatch(items, mode == "atomico");
+        client.sendBatch(batch);
         
-        double amount = std::stod(argv[4]);
-        std::string fromAccount = argv[5];
-        std::string serviceCode = argv[6];
-        
-        Transaction t = client.createPaymentTransaction(amount, fromAccount, serviceCode);
+    } else if (command == "schedule") {
+        const TransactionCommand* spec = argc >= 6 ? findTransactionCommand(argv[5]) : nullptr;
+        if (!spec || static_cast<size_t>(argc) != spec->arguments + 6) {
+            std::cerr << "[ERROR] Comando schedule requiere: <fecha|+segundos> <transfer|payment> [argumentos...]" << std::endl;
+            return 1;
+        }
+
+        std::string scheduledAt;
+        if (!parseScheduleTime(argv[4], scheduledAt)) {
+            std::cerr << "[ERROR] Fecha de ejecución inválida: " << argv[4] << std::endl;
+            return 1;
+        }
+
+        Transaction t = client.createSignedTransaction(*spec, std::vector<std::string>(argv + 6, argv + argc));
+        t.scheduledAt = scheduledAt;
+        std::cout << "[INFO] Ejecución programada para " << scheduledAt << std::endl;
         client.sendTransaction(t);
-        
-    } else if (command == "deposit") {
+
+    } else if (command == "pipeline") {
         if (argc != 6) {
-            std::cerr << "[ERROR] Comando deposit requiere: <monto> <cuenta_destino>" << std::endl;
+            std::cerr << "[ERROR] Comando pipeline requiere: <cantidad> <cuenta>" << std::endl;
             return 1;
         }
-        
-        double amount = std::stod(argv[4]);
-        std::string toAccount = argv[5];
-        
-        Transaction t = client.createDepositTransaction(amount, toAccount);
-        client.sendTransaction(t);
-        
+
+        size_t count = std::strtoul(argv[4], nullptr, 10);
+        if (count == 0) {
+            std::cerr << "[ERROR] Cantidad inválida: " << argv[4] << std::endl;
+            return 1;
+        }
+        client.runPipeline(count, argv[5]);
+
     } else {
         std::cerr << "[ERROR] Comando no reconocido: " << command << std::endl;
         printUsage(argv[0]);
@@ -3,13 +3,19 @@
 #include <sstream>
 #include <iomanip>
 #include <chrono>
+#include <ctime>
 #include <random>
 #include <cstring>
 #include <algorithm>
+#include <charconv>
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 #include <openssl/hmac.h>
 #include <openssl/err.h>
+#include <openssl/crypto.h>
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include <openssl/kdf.h>
 
 void CryptoUtils::handleOpenSSLErrors() {
     ERR_print_errors_fp(stderr);
@@ -60,6 +66,11 @@ bool CryptoUtils::validateDynamicToken(const std::string& token, const std::stri
 
 std::string CryptoUtils::encryptAES256(const std::string& plaintext, const std::string& key, 
                                      const std::string& iv) {
+    return encryptAES256(plaintext, key, reinterpret_cast<const unsigned char*>(iv.c_str()));
+}
+
+std::string CryptoUtils::encryptAES256(const std::string& plaintext, const std::string& key, 
+                                     const unsigned char* iv) {
     EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
     if (!ctx) {
         handleOpenSSLErrors();
@@ -67,8 +78,7 @@ std::string CryptoUtils::encryptAES256(const std::string& plaintext, const std::
     }
 
     if (EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), NULL, 
-                          reinterpret_cast<const unsigned char*>(key.c_str()),
-                          reinterpret_cast<const unsigned char*>(iv.c_str())) != 1) {
+                          reinterpret_cast<const unsigned char*>(key.c_str()), iv) != 1) {
         handleOpenSSLErrors();
         EVP_CIPHER_CTX_free(ctx);
         return "";
@@ -96,7 +106,9 @@ std::string CryptoUtils::encryptAES256(const std::string& plaintext, const std::
 
     EVP_CIPHER_CTX_free(ctx);
     
-    return base64Encode(std::vector<unsigned char>(ciphertext.begin(), ciphertext.begin() + ciphertext_len));
+    std::string encoded(base64EncodedLength(ciphertext_len), '\0');
+    base64Encode(ciphertext.data(), ciphertext_len, &encoded[0]);
+    return encoded;
 }
 
 std::string CryptoUtils::decryptAES256(const std::string& ciphertext, const std::string& key, 
@@ -111,44 +123,65 @@ std::string CryptoUtils::decryptAES256(const std::string& ciphertext, const std:
     
     std::cout << "[DEBUG] Datos cifrados decodificados: " << encrypted.size() << " bytes" << std::endl;
     
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) {
+    return decryptAES256(encrypted, key, iv);
+}
+
+// El contexto de descifrado se reutiliza por hilo: la expansión de la clave AES se
+// hace solo cuando la clave cambia y en cada mensaje se reinicia únicamente el IV.
+std::string CryptoUtils::decryptAES256(const std::vector<unsigned char>& encrypted, const std::string& key, 
+                                     const std::string& iv) {
+    struct DecryptContext {
+        EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+        std::string key;
+        bool keyed = false;
+
+        ~DecryptContext() {
+            EVP_CIPHER_CTX_free(ctx);
+            OPENSSL_cleanse(&key[0], key.size());
+        }
+    };
+    thread_local DecryptContext cipher;
+    if (!cipher.ctx) {
         handleOpenSSLErrors();
         return "";
     }
 
-    if (EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), NULL,
-                          reinterpret_cast<const unsigned char*>(key.c_str()),
-                          reinterpret_cast<const unsigned char*>(iv.c_str())) != 1) {
+    const unsigned char* ivBytes = reinterpret_cast<const unsigned char*>(iv.c_str());
+    int initResult;
+    if (cipher.keyed && cipher.key == key) {
+        initResult = EVP_DecryptInit_ex(cipher.ctx, NULL, NULL, NULL, ivBytes);
+    } else {
+        initResult = EVP_DecryptInit_ex(cipher.ctx, EVP_aes_256_cbc(), NULL,
+                                        reinterpret_cast<const unsigned char*>(key.c_str()), ivBytes);
+        cipher.key = key;
+        cipher.keyed = initResult == 1;
+    }
+    if (initResult != 1) {
         std::cout << "[ERROR] Error en EVP_DecryptInit_ex" << std::endl;
         handleOpenSSLErrors();
-        EVP_CIPHER_CTX_free(ctx);
         return "";
     }
 
-    std::vector<unsigned char> plaintext(encrypted.size() + 16);
+    std::string result(encrypted.size() + 16, '\0');
+    unsigned char* plaintext = reinterpret_cast<unsigned char*>(&result[0]);
     int len;
     int plaintext_len;
 
-    if (EVP_DecryptUpdate(ctx, plaintext.data(), &len, encrypted.data(), encrypted.size()) != 1) {
+    if (EVP_DecryptUpdate(cipher.ctx, plaintext, &len, encrypted.data(), encrypted.size()) != 1) {
         std::cout << "[ERROR] Error en EVP_DecryptUpdate" << std::endl;
         handleOpenSSLErrors();
-        EVP_CIPHER_CTX_free(ctx);
         return "";
     }
     plaintext_len = len;
 
-    if (EVP_DecryptFinal_ex(ctx, plaintext.data() + len, &len) != 1) {
+    if (EVP_DecryptFinal_ex(cipher.ctx, plaintext + len, &len) != 1) {
         std::cout << "[ERROR] Error en EVP_DecryptFinal_ex" << std::endl;
         handleOpenSSLErrors();
-        EVP_CIPHER_CTX_free(ctx);
         return "";
     }
     plaintext_len += len;
 
-    EVP_CIPHER_CTX_free(ctx);
-    
-    std::string result(reinterpret_cast<char*>(plaintext.data()), plaintext_len);
+    result.resize(plaintext_len);
     std::cout << "[DEBUG] Descifrado exitoso: " << result.length() << " bytes" << std::endl;
     
     return result;
@@ -172,60 +205,318 @@ std::string CryptoUtils::generateHMAC(const std::string& data, const std::string
 }
 
 bool CryptoUtils::verifyHMAC(const std::string& data, const std::string& hmac, const std::string& key) {
-    std::string computedHMAC = generateHMAC(data, key);
-    return computedHMAC == hmac;
+    return verifyHMAC({std::string_view(data)}, std::string_view(hmac), key);
 }
 
-std::string CryptoUtils::generateRandomBytes(int length) {
-    std::vector<unsigned char> buffer(length);
-    if (RAND_bytes(buffer.data(), length) != 1) {
+// Calcula el HMAC alimentando las partes en orden (equivale a concatenarlas) y
+// compara en tiempo constante contra la etiqueta recibida, decodificada una sola
+// vez a bytes. El contexto EVP_MAC se reutiliza por hilo y mantiene la clave.
+bool CryptoUtils::verifyHMAC(std::initializer_list<std::string_view> parts, std::string_view hexTag,
+                             const std::string& key) {
+    static const size_t TAG_LENGTH = 32; // SHA-256
+    if (hexTag.size() != TAG_LENGTH * 2) {
+        return false;
+    }
+
+    unsigned char expected[TAG_LENGTH];
+    for (size_t i = 0; i < TAG_LENGTH; i++) {
+        int high = hexValue(hexTag[2 * i]);
+        int low = hexValue(hexTag[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        expected[i] = static_cast<unsigned char>((high << 4) | low);
+    }
+
+    struct MacContext {
+        EVP_MAC_CTX* ctx = nullptr;
+        std::string key;
+        bool keyed = false;
+
+        MacContext() {
+            EVP_MAC* mac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+            if (mac) {
+                ctx = EVP_MAC_CTX_new(mac);
+                EVP_MAC_free(mac);
+            }
+        }
+        ~MacContext() {
+            EVP_MAC_CTX_free(ctx);
+            OPENSSL_cleanse(&key[0], key.size());
+        }
+    };
+    thread_local MacContext mac;
+    if (!mac.ctx) {
         handleOpenSSLErrors();
-        return "";
+        return false;
     }
-    return std::string(reinterpret_cast<char*>(buffer.data()), length);
+
+    // Con la misma clave que el mensaje anterior EVP_MAC_init reutiliza el estado
+    // ya preparado (ipad/opad) en lugar de volver a procesar la clave
+    int initResult;
+    if (mac.keyed && mac.key == key) {
+        initResult = EVP_MAC_init(mac.ctx, NULL, 0, NULL);
+    } else {
+        char digestName[] = "SHA256";
+        OSSL_PARAM params[] = {
+            OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digestName, 0),
+            OSSL_PARAM_construct_end()
+        };
+        initResult = EVP_MAC_init(mac.ctx, reinterpret_cast<const unsigned char*>(key.data()), key.size(), params);
+        mac.key = key;
+        mac.keyed = initResult == 1;
+    }
+    if (initResult != 1) {
+        handleOpenSSLErrors();
+        return false;
+    }
+    for (std::string_view part : parts) {
+        if (EVP_MAC_update(mac.ctx, reinterpret_cast<const unsigned char*>(part.data()), part.size()) != 1) {
+            handleOpenSSLErrors();
+            return false;
+        }
+    }
+
+    unsigned char computed[EVP_MAX_MD_SIZE];
+    size_t computedLength = 0;
+    if (EVP_MAC_final(mac.ctx, computed, &computedLength, sizeof(computed)) != 1 ||
+        computedLength != TAG_LENGTH) {
+        handleOpenSSLErrors();
+        return false;
+    }
+
+    return CRYPTO_memcmp(computed, expected, TAG_LENGTH) == 0;
 }
 
-std::string CryptoUtils::generateUUID() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 15);
-    std::uniform_int_distribution<> dis2(8, 11);
+int CryptoUtils::hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
 
-    std::stringstream ss;
-    int i;
-    ss << std::hex;
-    for (i = 0; i < 8; i++) {
-        ss << dis(gen);
+std::string CryptoUtils::generateRandomBytes(int length) {
+    std::string buffer(length, '\0');
+    if (!fillRandomBytes(reinterpret_cast<unsigned char*>(&buffer[0]), length)) {
+        return "";
     }
-    ss << "-";
-    for (i = 0; i < 4; i++) {
-        ss << dis(gen);
+    return buffer;
+}
+
+// Reserva de bytes aleatorios por hilo: RAND_bytes se llama una vez cada
+// RANDOM_POOL_SIZE bytes en lugar de una vez por IV. Los bytes entregados se
+// borran de la reserva para que no queden en memoria después de usarse.
+bool CryptoUtils::fillRandomBytes(unsigned char* out, size_t length) {
+    struct RandomPool {
+        unsigned char bytes[RANDOM_POOL_SIZE];
+        size_t available = 0;
+
+        ~RandomPool() { OPENSSL_cleanse(bytes, sizeof(bytes)); }
+    };
+    thread_local RandomPool pool;
+
+    // Peticiones grandes (claves, nonces largos) van directo a OpenSSL
+    if (length > RANDOM_POOL_SIZE / 4) {
+        if (RAND_bytes(out, static_cast<int>(length)) != 1) {
+            handleOpenSSLErrors();
+            return false;
+        }
+        return true;
     }
-    ss << "-4";
-    for (i = 0; i < 3; i++) {
-        ss << dis(gen);
+
+    if (pool.available < length) {
+        if (RAND_bytes(pool.bytes, RANDOM_POOL_SIZE) != 1) {
+            handleOpenSSLErrors();
+            pool.available = 0;
+            return false;
+        }
+        pool.available = RANDOM_POOL_SIZE;
     }
-    ss << "-";
-    ss << dis2(gen);
-    for (i = 0; i < 3; i++) {
-        ss << dis(gen);
+
+    unsigned char* source = pool.bytes + (RANDOM_POOL_SIZE - pool.available);
+    memcpy(out, source, length);
+    OPENSSL_cleanse(source, length);
+    pool.available -= length;
+    return true;
+}
+
+// xoshiro256** por hilo, sembrado una sola vez con RAND_bytes. Evita construir un
+// std::random_device y un mt19937 (2.5 KB de estado) en cada UUID.
+uint64_t CryptoUtils::nextRandom64() {
+    struct Xoshiro256 {
+        uint64_t s[4];
+        bool seeded = false;
+    };
+    thread_local Xoshiro256 state;
+
+    if (!state.seeded) {
+        if (RAND_bytes(reinterpret_cast<unsigned char*>(state.s), sizeof(state.s)) != 1) {
+            handleOpenSSLErrors();
+            std::random_device rd;
+            for (auto& word : state.s) {
+                word = (static_cast<uint64_t>(rd()) << 32) ^ rd();
+            }
+        }
+        state.s[0] |= 1; // el estado no puede ser todo ceros
+        state.seeded = true;
     }
-    ss << "-";
-    for (i = 0; i < 12; i++) {
-        ss << dis(gen);
+
+    uint64_t* s = state.s;
+    auto rotl = [](uint64_t x, int k) { return (x << k) | (x >> (64 - k)); };
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+void CryptoUtils::formatUUIDBytes(const unsigned char bytes[16], char* out) {
+    static const char hex[] = "0123456789abcdef";
+    for (int i = 0; i < 16; i++) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            *out++ = '-';
+        }
+        *out++ = hex[bytes[i] >> 4];
+        *out++ = hex[bytes[i] & 0x0f];
     }
-    return ss.str();
+}
+
+void CryptoUtils::formatUUIDv4(char* out) {
+    uint64_t high = nextRandom64();
+    uint64_t low = nextRandom64();
+    unsigned char bytes[16];
+    memcpy(bytes, &high, 8);
+    memcpy(bytes + 8, &low, 8);
+    bytes[6] = (bytes[6] & 0x0f) | 0x40; // versión 4
+    bytes[8] = (bytes[8] & 0x3f) | 0x80; // variante RFC 4122
+    formatUUIDBytes(bytes, out);
+}
+
+void CryptoUtils::formatUUIDv7(char* out) {
+    uint64_t millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t random = nextRandom64();
+    unsigned char bytes[16];
+    for (int i = 0; i < 6; i++) {
+        bytes[i] = static_cast<unsigned char>(millis >> (40 - 8 * i));
+    }
+    memcpy(bytes + 6, &random, 8);
+    uint64_t extra = nextRandom64();
+    memcpy(bytes + 14, &extra, 2);
+    bytes[6] = (bytes[6] & 0x0f) | 0x70; // versión 7
+    bytes[8] = (bytes[8] & 0x3f) | 0x80; // variante RFC 4122
+    formatUUIDBytes(bytes, out);
+}
+
+std::string CryptoUtils::generateUUID() {
+    char buffer[UUID_LENGTH];
+    formatUUIDv4(buffer);
+    return std::string(buffer, UUID_LENGTH);
+}
+
+std::string CryptoUtils::generateUUIDv7() {
+    char buffer[UUID_LENGTH];
+    formatUUIDv7(buffer);
+    return std::string(buffer, UUID_LENGTH);
 }
 
 std::string CryptoUtils::getCurrentTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-    
-    std::stringstream ss;
-    ss << std::put_time(std::gmtime(&time_t), "%Y-%m-%dT%H:%M:%S");
-    ss << '.' << std::setfill('0') << std::setw(3) << ms.count() << 'Z';
-    return ss.str();
+    char buffer[TIMESTAMP_LENGTH];
+    return std::string(buffer, formatTimestamp(buffer));
+}
+
+// Cada hilo guarda el prefijo "YYYY-MM-DDTHH:MM:SS" del último segundo formateado;
+// mientras no cambie el segundo solo se reescriben los milisegundos. clock_gettime
+// con CLOCK_REALTIME se resuelve en el vDSO, sin entrar al kernel, y gmtime_r es
+// seguro entre hilos (gmtime comparte un búfer estático).
+size_t CryptoUtils::formatTimestamp(char* out) {
+    struct TimestampCache {
+        time_t second = -1;
+        char prefix[20];
+    };
+    thread_local TimestampCache cache;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    if (now.tv_sec != cache.second) {
+        struct tm utc;
+        gmtime_r(&now.tv_sec, &utc);
+        strftime(cache.prefix, sizeof(cache.prefix), "%Y-%m-%dT%H:%M:%S", &utc);
+        cache.second = now.tv_sec;
+    }
+
+    int ms = static_cast<int>(now.tv_nsec / 1000000);
+    memcpy(out, cache.prefix, 19);
+    out[19] = '.';
+    out[20] = static_cast<char>('0' + ms / 100);
+    out[21] = static_cast<char>('0' + (ms / 10) % 10);
+    out[22] = static_cast<char>('0' + ms % 10);
+    out[23] = 'Z';
+    return TIMESTAMP_LENGTH;
+}
+
+namespace {
+
+bool parseDigits(std::string_view text, size_t offset, size_t count, int& value) {
+    value = 0;
+    for (size_t i = offset; i < offset + count; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+// AAAA-MM-DDTHH:MM:SS.mmmZ, el formato de formatTimestamp
+bool CryptoUtils::parseTimestamp(std::string_view text, int64_t& millis) {
+    if (text.size() != TIMESTAMP_LENGTH || text[4] != '-' || text[7] != '-' ||
+        text[10] != 'T' || text[13] != ':' || text[16] != ':' || text[19] != '.' || text[23] != 'Z') {
+        return false;
+    }
+    int year, month, day, hour, minute, second, ms;
+    if (!parseDigits(text, 0, 4, year) || !parseDigits(text, 5, 2, month) || !parseDigits(text, 8, 2, day) ||
+        !parseDigits(text, 11, 2, hour) || !parseDigits(text, 14, 2, minute) ||
+        !parseDigits(text, 17, 2, second) || !parseDigits(text, 20, 3, ms)) {
+        return false;
+    }
+    struct tm utc = {};
+    utc.tm_year = year - 1900;
+    utc.tm_mon = month - 1;
+    utc.tm_mday = day;
+    utc.tm_hour = hour;
+    utc.tm_min = minute;
+    utc.tm_sec = second;
+    time_t seconds = timegm(&utc);
+    millis = static_cast<int64_t>(seconds) * 1000 + ms;
+
+    // Fechas fuera de rango (mes 13, día 32...) se normalizarían: se guardan como texto
+    struct tm check;
+    gmtime_r(&seconds, &check);
+    return millis >= 0 && check.tm_year == utc.tm_year && check.tm_mon == month - 1 && check.tm_mday == day &&
+           check.tm_hour == hour && check.tm_min == minute && check.tm_sec == second;
+}
+
+std::string CryptoUtils::formatTimestampMillis(int64_t millis) {
+    time_t seconds = static_cast<time_t>(millis / 1000);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+    char buffer[32];
+    size_t length = strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+    int ms = static_cast<int>(millis % 1000);
+    buffer[length++] = '.';
+    buffer[length++] = static_cast<char>('0' + ms / 100);
+    buffer[length++] = static_cast<char>('0' + (ms / 10) % 10);
+    buffer[length++] = static_cast<char>('0' + ms % 10);
+    buffer[length++] = 'Z';
+    return std::string(buffer, length);
 }
 
 long long CryptoUtils::getUnixTimestamp() {
@@ -293,47 +584,41 @@ bool CryptoUtils::isTimestampValid(long long timestamp, int maxAgeSeconds) {
 
 // Base64 encoding/decoding simplificado
 std::string CryptoUtils::base64Encode(const std::vector<unsigned char>& data) {
-    static const std::string chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    std::string ret;
-    int i = 0;
-    int j = 0;
-    unsigned char char_array_3[3];
-    unsigned char char_array_4[4];
-
-    for (size_t idx = 0; idx < data.size(); idx++) {
-        char_array_3[i++] = data[idx];
-        if (i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-
-            for(i = 0; (i <4) ; i++)
-                ret += chars[char_array_4[i]];
-            i = 0;
-        }
-    }
-
-    if (i) {
-        for(j = i; j < 3; j++)
-            char_array_3[j] = '\0';
-
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-        char_array_4[3] = char_array_3[2] & 0x3f;
+    std::string ret(base64EncodedLength(data.size()), '\0');
+    base64Encode(data.data(), data.size(), &ret[0]);
+    return ret;
+}
 
-        for (j = 0; (j < i + 1); j++)
-            ret += chars[char_array_4[j]];
+size_t CryptoUtils::base64Encode(const unsigned char* data, size_t length, char* out) {
+    static const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char* start = out;
+    size_t idx = 0;
+
+    for (; idx + 3 <= length; idx += 3) {
+        uint32_t triple = (static_cast<uint32_t>(data[idx]) << 16) |
+                          (static_cast<uint32_t>(data[idx + 1]) << 8) | data[idx + 2];
+        *out++ = chars[(triple >> 18) & 0x3f];
+        *out++ = chars[(triple >> 12) & 0x3f];
+        *out++ = chars[(triple >> 6) & 0x3f];
+        *out++ = chars[triple & 0x3f];
+    }
 
-        while((i++ < 3))
-            ret += '=';
+    size_t remaining = length - idx;
+    if (remaining) {
+        uint32_t triple = static_cast<uint32_t>(data[idx]) << 16;
+        if (remaining == 2) {
+            triple |= static_cast<uint32_t>(data[idx + 1]) << 8;
+        }
+        *out++ = chars[(triple >> 18) & 0x3f];
+        *out++ = chars[(triple >> 12) & 0x3f];
+        *out++ = remaining == 2 ? chars[(triple >> 6) & 0x3f] : '=';
+        *out++ = '=';
     }
 
-    return ret;
+    return out - start;
 }
 
-std::vector<unsigned char> CryptoUtils::base64Decode(const std::string& encoded_string) {
+std::vector<unsigned char> CryptoUtils::base64Decode(std::string_view encoded_string) {
     static const std::string chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
     int in_len = encoded_string.size();
     int i = 0;
@@ -377,12 +662,210 @@ std::vector<unsigned char> CryptoUtils::base64Decode(const std::string& encoded_
 }
 
 // Implementación de Transaction
+bool CryptoUtils::hkdfSha256(std::string_view secret, const unsigned char* salt, size_t saltLength,
+                             std::string_view info, unsigned char* out, size_t outLength) {
+    EVP_KDF* kdf = EVP_KDF_fetch(NULL, "HKDF", NULL);
+    EVP_KDF_CTX* ctx = kdf ? EVP_KDF_CTX_new(kdf) : nullptr;
+    EVP_KDF_free(kdf);
+    if (!ctx) {
+        handleOpenSSLErrors();
+        return false;
+    }
+
+    char digestName[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST, digestName, 0),
+        OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_KEY, const_cast<char*>(secret.data()), secret.size()),
+        OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT, const_cast<unsigned char*>(salt), saltLength),
+        OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_INFO, const_cast<char*>(info.data()), info.size()),
+        OSSL_PARAM_construct_end()
+    };
+    bool ok = EVP_KDF_derive(ctx, out, outLength, params) == 1;
+    if (!ok) {
+        handleOpenSSLErrors();
+    }
+    EVP_KDF_CTX_free(ctx);
+    return ok;
+}
+
+bool CryptoUtils::encryptAES256GCM(EVP_CIPHER_CTX* ctx, const unsigned char* nonce,
+                                   std::string_view plaintext, std::string& out) {
+    size_t start = out.size();
+    out.resize(start + plaintext.size() + GCM_TAG_LENGTH);
+    unsigned char* ciphertext = reinterpret_cast<unsigned char*>(&out[start]);
+    int len = 0;
+    int finalLen = 0;
+    bool ok = EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, nonce) == 1 &&
+              EVP_EncryptUpdate(ctx, ciphertext, &len,
+                                reinterpret_cast<const unsigned char*>(plaintext.data()), plaintext.size()) == 1 &&
+              EVP_EncryptFinal_ex(ctx, ciphertext + len, &finalLen) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, GCM_TAG_LENGTH, ciphertext + len + finalLen) == 1;
+
+    if (!ok) {
+        handleOpenSSLErrors();
+        out.resize(start);
+    }
+    return ok;
+}
+
+bool CryptoUtils::decryptAES256GCM(EVP_CIPHER_CTX* ctx, const unsigned char* nonce,
+                                   const unsigned char* data, size_t length, std::string& out) {
+    if (length < GCM_TAG_LENGTH) {
+        return false;
+    }
+
+    size_t ciphertextLength = length - GCM_TAG_LENGTH;
+    out.resize(ciphertextLength);
+    unsigned char* plaintext = reinterpret_cast<unsigned char*>(&out[0]);
+    int len = 0;
+    int finalLen = 0;
+    // La etiqueta se fija antes de Final: si no coincide, Final falla y no se entrega nada
+    bool ok = EVP_DecryptInit_ex(ctx, NULL, NULL, NULL, nonce) == 1 &&
+              EVP_DecryptUpdate(ctx, plaintext, &len, data, ciphertextLength) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, GCM_TAG_LENGTH,
+                                  const_cast<unsigned char*>(data + ciphertextLength)) == 1 &&
+              EVP_DecryptFinal_ex(ctx, plaintext + len, &finalLen) == 1;
+
+    if (!ok) {
+        OPENSSL_cleanse(&out[0], out.size());
+        out.clear();
+        return false;
+    }
+    out.resize(len + finalLen);
+    return true;
+}
+
+SecureSession::~SecureSession() {
+    EVP_CIPHER_CTX_free(sealContext);
+    EVP_CIPHER_CTX_free(openContext);
+    OPENSSL_cleanse(key, sizeof(key));
+}
+
+bool SecureSession::establish(const std::string& secretKey, const std::string& aesKey,
+                              const unsigned char* clientNonce, const unsigned char* serverNonce) {
+    unsigned char salt[2 * HANDSHAKE_NONCE_LENGTH];
+    memcpy(salt, clientNonce, HANDSHAKE_NONCE_LENGTH);
+    memcpy(salt + HANDSHAKE_NONCE_LENGTH, serverNonce, HANDSHAKE_NONCE_LENGTH);
+
+    std::string secret = aesKey + secretKey;
+    established = CryptoUtils::hkdfSha256(secret, salt, sizeof(salt), "transaction-session-v1",
+                                          key, KEY_LENGTH);
+    OPENSSL_cleanse(&secret[0], secret.size());
+    sequence = 0;
+
+    // Un nuevo handshake cambia la clave: los contextos se vuelven a preparar
+    EVP_CIPHER_CTX_free(sealContext);
+    EVP_CIPHER_CTX_free(openContext);
+    sealContext = nullptr;
+    openContext = nullptr;
+    return established;
+}
+
+EVP_CIPHER_CTX* SecureSession::cipherFor(EVP_CIPHER_CTX*& ctx, bool encrypt) {
+    if (ctx) {
+        return ctx;
+    }
+    ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) {
+        return nullptr;
+    }
+    int result = encrypt ? EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), NULL, key, NULL)
+                         : EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), NULL, key, NULL);
+    if (result != 1) {
+        EVP_CIPHER_CTX_free(ctx);
+        ctx = nullptr;
+    }
+    return ctx;
+}
+
+std::string SecureSession::helloTag(const std::string& secretKey, std::string_view clientNonce) {
+    return CryptoUtils::generateHMAC("HELLO|" + std::string(clientNonce), secretKey);
+}
+
+std::string SecureSession::sessionTag(const std::string& secretKey, std::string_view clientNonce,
+                                      std::string_view serverNonce) {
+    return CryptoUtils::generateHMAC("SESSION|" + std::string(clientNonce) + "|" + std::string(serverNonce),
+                                     secretKey);
+}
+
+void SecureSession::nonceFor(uint64_t sequence, unsigned char* nonce) {
+    memset(nonce, 0, CryptoUtils::GCM_NONCE_LENGTH);
+    for (int i = 0; i < 8; i++) {
+        nonce[CryptoUtils::GCM_NONCE_LENGTH - 1 - i] = static_cast<unsigned char>(sequence >> (8 * i));
+    }
+}
+
+bool SecureSession::seal(std::string_view plaintext, std::string& out) {
+    if (!established || sequence == UINT64_MAX) {
+        return false;
+    }
+    EVP_CIPHER_CTX* ctx = cipherFor(sealContext, true);
+    if (!ctx) {
+        return false;
+    }
+    uint64_t next = sequence + 1;
+    unsigned char nonce[CryptoUtils::GCM_NONCE_LENGTH];
+    nonceFor(next, nonce);
+
+    scratch.clear();
+    if (!CryptoUtils::encryptAES256GCM(ctx, nonce, plaintext, scratch)) {
+        return false;
+    }
+    sequence = next;
+
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), next);
+    out.clear();
+    out.append("S:", 2);
+    out.append(digits, result.ptr - digits);
+    out.push_back(':');
+    size_t start = out.size();
+    out.resize(start + CryptoUtils::base64EncodedLength(scratch.size()));
+    CryptoUtils::base64Encode(reinterpret_cast<const unsigned char*>(scratch.data()), scratch.size(), &out[start]);
+    return true;
+}
+
+bool SecureSession::open(std::string_view message, std::string& plaintext) {
+    if (!established || !isSessionMessage(message)) {
+        return false;
+    }
+    size_t colon = message.find(':', 2);
+    if (colon == std::string_view::npos || colon == 2) {
+        return false;
+    }
+
+    uint64_t received = 0;
+    for (size_t i = 2; i < colon; i++) {
+        char c = message[i];
+        if (c < '0' || c > '9' || received > (UINT64_MAX - 9) / 10) {
+            return false;
+        }
+        received = received * 10 + static_cast<uint64_t>(c - '0');
+    }
+    if (received <= sequence) {
+        return false; // repetido o fuera de orden
+    }
+
+    EVP_CIPHER_CTX* ctx = cipherFor(openContext, false);
+    if (!ctx) {
+        return false;
+    }
+    std::vector<unsigned char> sealed = CryptoUtils::base64Decode(message.substr(colon + 1));
+    unsigned char nonce[CryptoUtils::GCM_NONCE_LENGTH];
+    nonceFor(received, nonce);
+    if (!CryptoUtils::decryptAES256GCM(ctx, nonce, sealed.data(), sealed.size(), plaintext)) {
+        return false;
+    }
+    sequence = received;
+    return true;
+}
+
 std::string Transaction::toJson() const {
     std::stringstream ss;
     ss << "{\n";
     ss << "  \"id\": \"" << id << "\",\n";
     ss << "  \"timestamp\": \"" << timestamp << "\",\n";
-    ss << "  \"type\": \"" << type << "\",\n";
+    ss << "  \"type\": \"" << transactionTypeName(type) << "\",\n";
     ss << "  \"amount\": " << amount << ",\n";
     ss << "  \"account_from\": \"" << accountFrom << "\",\n";
     ss << "  \"account_to\": \"" << accountTo << "\",\n";
@@ -394,20 +877,71 @@ std::string Transaction::toJson() const {
 }
 
 std::string Transaction::serialize() const {
-    std::string result = id + "|" + timestamp + "|" + type + "|" + std::to_string(amount) + "|" + 
-                        accountFrom + "|" + accountTo + "|" + serviceCode + "|" + dynamicToken + "|" + hmac;
-    
-    std::cout << "[DEBUG] Serializando transacción:" << std::endl;
-    std::cout << "[DEBUG]   ID: '" << id << "'" << std::endl;
-    std::cout << "[DEBUG]   Timestamp: '" << timestamp << "'" << std::endl;
-    std::cout << "[DEBUG]   Type: '" << type << "'" << std::endl;
-    std::cout << "[DEBUG]   Amount: " << amount << std::endl;
-    std::cout << "[DEBUG]   Token: '" << dynamicToken.substr(0, 16) << "...'" << std::endl;
-    std::cout << "[DEBUG] Resultado serializado: " << result.substr(0, 100) << "..." << std::endl;
-    
+    std::string result;
+    serializeTo(result);
     return result;
 }
 
+// Mismo formato que antes ("%f" para el monto, como std::to_string), escrito campo a
+// campo sobre `out` sin cadenas temporales
+void Transaction::serializeTo(std::string& out) const {
+    char amountDigits[64];
+    auto amountEnd = std::to_chars(amountDigits, amountDigits + sizeof(amountDigits), amount,
+                                   std::chars_format::fixed, 6);
+
+    out.append(id).push_back('|');
+    out.append(timestamp).push_back('|');
+    out.append(transactionTypeName(type)).push_back('|');
+    if (amountEnd.ec == std::errc()) {
+        out.append(amountDigits, amountEnd.ptr - amountDigits);
+    } else {
+        out.append(std::to_string(amount));
+    }
+    out.push_back('|');
+    out.append(accountFrom).push_back('|');
+    out.append(accountTo).push_back('|');
+    out.append(serviceCode).push_back('|');
+    out.append(dynamicToken).push_back('|');
+    out.append(hmac);
+    if (!scheduledAt.empty()) {
+        out.push_back('|');
+        out.append(scheduledAt);
+    }
+}
+
+bool Transaction::deserialize(std::string_view text, Transaction& out) {
+    std::string_view fields[10];
+    size_t count = 0;
+    while (count < 10) {
+        size_t separator = text.find('|');
+        fields[count++] = text.substr(0, separator);
+        if (separator == std::string_view::npos) {
+            break;
+        }
+        text.remove_prefix(separator + 1);
+    }
+    if (count < 8) {
+        return false;
+    }
+
+    double amount = 0.0;
+    auto parsed = std::from_chars(fields[3].data(), fields[3].data() + fields[3].size(), amount);
+    if (parsed.ec != std::errc()) {
+        return false;
+    }
+    out.id = fields[0];
+    out.timestamp = fields[1];
+    out.type = transactionTypeFromString(fields[2]);
+    out.amount = amount;
+    out.accountFrom = fields[4];
+    out.accountTo = fields[5];
+    out.serviceCode = fields[6];
+    out.dynamicToken = fields[7];
+    out.hmac = count > 8 ? fields[8] : std::string_view();
+    out.scheduledAt = count > 9 ? fields[9] : std::string_view();
+    return true;
+}
+
 Transaction Transaction::fromJson(const std::string& json) {
     Transaction t;
     // Implementación básica de parsing JSON
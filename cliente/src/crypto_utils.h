@@ -2,7 +2,10 @@
 #define CRYPTO_UTILS_H
 
 #include <string>
+#include <string_view>
+#include <initializer_list>
 #include <vector>
+#include <cstdint>
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 #include <openssl/hmac.h>
@@ -19,17 +22,43 @@ public:
     // Cifrado AES-256-CBC
     static std::string encryptAES256(const std::string& plaintext, const std::string& key, 
                                    const std::string& iv);
+    // Variante con el IV (16 bytes) en un búfer del llamador
+    static std::string encryptAES256(const std::string& plaintext, const std::string& key, 
+                                   const unsigned char* iv);
     static std::string decryptAES256(const std::string& ciphertext, const std::string& key, 
                                    const std::string& iv);
+    // Variante sobre el texto cifrado ya decodificado de Base64
+    static std::string decryptAES256(const std::vector<unsigned char>& encrypted, const std::string& key, 
+                                   const std::string& iv);
     
     // Generación de HMAC-SHA256
     static std::string generateHMAC(const std::string& data, const std::string& key);
     static bool verifyHMAC(const std::string& data, const std::string& hmac, const std::string& key);
+    // Verificación sin copias: las partes se procesan en orden como si estuvieran
+    // concatenadas y la etiqueta hexadecimal se compara en tiempo constante
+    static bool verifyHMAC(std::initializer_list<std::string_view> parts, std::string_view hexTag,
+                           const std::string& key);
     
     // Utilidades generales
     static std::string generateRandomBytes(int length);
+    // Bytes aleatorios desde la reserva del hilo, sin reservar memoria (p. ej. IVs)
+    static const size_t RANDOM_POOL_SIZE = 4096;
+    static bool fillRandomBytes(unsigned char* out, size_t length);
     static std::string generateUUID();
+    // UUIDv7: prefijo de tiempo en milisegundos, se ordena por creación
+    static std::string generateUUIDv7();
+    // Escriben el UUID (UUID_LENGTH caracteres, sin terminador) directamente en `out`
+    static const size_t UUID_LENGTH = 36;
+    static void formatUUIDv4(char* out);
+    static void formatUUIDv7(char* out);
     static std::string getCurrentTimestamp();
+    // Escribe el timestamp ISO-8601 (TIMESTAMP_LENGTH caracteres, sin terminador) en `out`
+    static const size_t TIMESTAMP_LENGTH = 24;
+    static size_t formatTimestamp(char* out);
+    // Conversión entre el formato anterior y milisegundos desde epoch (UTC). El parseo
+    // es estricto: rechaza fechas fuera de rango en lugar de normalizarlas.
+    static bool parseTimestamp(std::string_view text, int64_t& millis);
+    static std::string formatTimestampMillis(int64_t millis);
     static long long getUnixTimestamp();
     static std::string bytesToHex(const unsigned char* bytes, int length);
     static std::vector<unsigned char> hexToBytes(const std::string& hex);
@@ -40,27 +69,133 @@ public:
     
     // Funciones de codificación Base64 (públicas)
     static std::string base64Encode(const std::vector<unsigned char>& data);
-    static std::vector<unsigned char> base64Decode(const std::string& encoded);
+    // Escribe base64EncodedLength(length) caracteres en `out` y devuelve cuántos escribió
+    static size_t base64Encode(const unsigned char* data, size_t length, char* out);
+    static size_t base64EncodedLength(size_t length) { return 4 * ((length + 2) / 3); }
+
+    // HKDF-SHA256 (RFC 5869): deriva `outLength` bytes de `secret` con sal y contexto
+    static bool hkdfSha256(std::string_view secret, const unsigned char* salt, size_t saltLength,
+                           std::string_view info, unsigned char* out, size_t outLength);
+
+    // AES-256-GCM con nonce de 12 bytes sobre un contexto ya inicializado con la clave
+    // (solo se cambia el nonce por mensaje). El texto cifrado lleva la etiqueta de 16
+    // bytes al final y se agrega a `out`; el descifrado reemplaza el contenido de `out`.
+    static const size_t GCM_NONCE_LENGTH = 12;
+    static const size_t GCM_TAG_LENGTH = 16;
+    static bool encryptAES256GCM(EVP_CIPHER_CTX* ctx, const unsigned char* nonce,
+                                 std::string_view plaintext, std::string& out);
+    static bool decryptAES256GCM(EVP_CIPHER_CTX* ctx, const unsigned char* nonce,
+                                 const unsigned char* data, size_t length, std::string& out);
+    static std::vector<unsigned char> base64Decode(std::string_view encoded);
 
 private:
     static void handleOpenSSLErrors();
+    static int hexValue(char c);
+    static uint64_t nextRandom64();
+    static void formatUUIDBytes(const unsigned char bytes[16], char* out);
 };
 
+// Sesión segura por conexión. El handshake intercambia un nonce de cada lado
+// autenticado con la clave secreta; la clave de sesión se deriva con HKDF de las
+// claves compartidas y ambos nonces. Cada mensaje de la sesión es "S:<seq>:<base64>",
+// cifrado con AES-256-GCM usando el número de secuencia como nonce: el receptor
+// solo acepta números crecientes, lo que da frescura sin token dinámico.
+class SecureSession {
+public:
+    static const size_t HANDSHAKE_NONCE_LENGTH = 16;
+    static const size_t KEY_LENGTH = 32;
+
+    SecureSession() = default;
+    SecureSession(const SecureSession&) = delete;
+    SecureSession& operator=(const SecureSession&) = delete;
+    ~SecureSession();
+
+    bool establish(const std::string& secretKey, const std::string& aesKey,
+                   const unsigned char* clientNonce, const unsigned char* serverNonce);
+    bool isEstablished() const { return established; }
+
+    // Etiquetas HMAC de los mensajes "HELLO|<nonce>" y "SESSION|<nonce>"
+    static std::string helloTag(const std::string& secretKey, std::string_view clientNonce);
+    static std::string sessionTag(const std::string& secretKey, std::string_view clientNonce,
+                                  std::string_view serverNonce);
+
+    static bool isSessionMessage(std::string_view message) { return message.compare(0, 2, "S:") == 0; }
+
+    // Emisor: cifra con el siguiente número de secuencia y escribe el mensaje en `out`
+    // (reutiliza su capacidad; sin reservas de memoria una vez que alcanzó el tamaño)
+    bool seal(std::string_view plaintext, std::string& out);
+    // Receptor: rechaza secuencias repetidas o antiguas y descifra en `plaintext`
+    bool open(std::string_view message, std::string& plaintext);
+
+    uint64_t lastSequence() const { return sequence; }
+
+private:
+    static void nonceFor(uint64_t sequence, unsigned char* nonce);
+    // Contexto AES-GCM de la sesión con la clave ya expandida, creado al primer uso
+    EVP_CIPHER_CTX* cipherFor(EVP_CIPHER_CTX*& ctx, bool encrypt);
+
+    unsigned char key[KEY_LENGTH] = {};
+    bool established = false;
+    uint64_t sequence = 0; // último número enviado o aceptado
+    EVP_CIPHER_CTX* sealContext = nullptr;
+    EVP_CIPHER_CTX* openContext = nullptr;
+    std::string scratch; // texto cifrado + etiqueta antes de codificar / descifrar
+};
+
+// Tipos de transacción. El texto del protocolo se traduce una sola vez al recibir o
+// armar el mensaje; de ahí en adelante se despacha por el valor del enum.
+enum class TransactionType : uint8_t {
+    Transfer,
+    Balance,
+    Payment,
+    Deposit,
+    Unknown // cualquier texto no reconocido; siempre el último
+};
+
+constexpr size_t TRANSACTION_TYPE_COUNT = static_cast<size_t>(TransactionType::Unknown) + 1;
+
+constexpr std::string_view transactionTypeName(TransactionType type) {
+    switch (type) {
+    case TransactionType::Transfer: return "TRANSFER";
+    case TransactionType::Balance: return "BALANCE";
+    case TransactionType::Payment: return "PAYMENT";
+    case TransactionType::Deposit: return "DEPOSIT";
+    default: return "UNKNOWN";
+    }
+}
+
+constexpr TransactionType transactionTypeFromString(std::string_view text) {
+    for (size_t i = 0; i + 1 < TRANSACTION_TYPE_COUNT; i++) {
+        TransactionType type = static_cast<TransactionType>(i);
+        if (text == transactionTypeName(type)) {
+            return type;
+        }
+    }
+    return TransactionType::Unknown;
+}
+
 // Estructura para las transacciones
 struct Transaction {
     std::string id;
     std::string timestamp;
-    std::string type;
+    TransactionType type = TransactionType::Unknown;
     double amount;
     std::string accountFrom;
     std::string accountTo;
     std::string serviceCode;
     std::string dynamicToken;
     std::string hmac;
+    // Ejecución diferida: vacío = inmediata; si no, timestamp ISO-8601 como `timestamp`.
+    // Viaja como décimo campo solo cuando está presente.
+    std::string scheduledAt;
     
     std::string toJson() const;
     static Transaction fromJson(const std::string& json);
     std::string serialize() const;
+    // Agrega la forma serializada a `out` (reutilizable entre mensajes)
+    void serializeTo(std::string& out) const;
+    // Inversa de serialize(); false si faltan campos o el monto no es un número
+    static bool deserialize(std::string_view text, Transaction& out);
 };
 
 #endif // CRYPTO_UTILS_H
\ No newline at end of file
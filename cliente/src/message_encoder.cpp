@@ -0,0 +1,118 @@
+#include "message_encoder.h"
+#include <iostream>
+#include <cstring>
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include <openssl/err.h>
+
+MessageEncoder::MessageEncoder(const std::string& aesKey, const std::string& secretKey)
+    : cipher(EVP_CIPHER_CTX_new()), mac(nullptr), ready(false) {
+    EVP_MAC* hmac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+    if (hmac) {
+        mac = EVP_MAC_CTX_new(hmac);
+        EVP_MAC_free(hmac);
+    }
+
+    if (aesKey.length() != 32) {
+        std::cerr << "[ERROR] Clave AES debe ser de 32 bytes, actual: " << aesKey.length() << std::endl;
+        return;
+    }
+    if (!cipher || !mac) {
+        ERR_print_errors_fp(stderr);
+        return;
+    }
+
+    // Las claves se cargan una sola vez; por mensaje solo se cambia el IV
+    char digestName[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digestName, 0),
+        OSSL_PARAM_construct_end()
+    };
+    ready = EVP_EncryptInit_ex(cipher, EVP_aes_256_cbc(), NULL,
+                               reinterpret_cast<const unsigned char*>(aesKey.data()), NULL) == 1 &&
+            EVP_MAC_init(mac, reinterpret_cast<const unsigned char*>(secretKey.data()),
+                         secretKey.size(), params) == 1;
+    if (!ready) {
+        ERR_print_errors_fp(stderr);
+    }
+}
+
+MessageEncoder::~MessageEncoder() {
+    EVP_CIPHER_CTX_free(cipher);
+    EVP_MAC_CTX_free(mac);
+}
+
+std::string& MessageEncoder::beginPlaintext() {
+    plaintext.clear();
+    return plaintext;
+}
+
+bool MessageEncoder::finish(SecureSession* session) {
+    if (session && session->isEstablished()) {
+        if (!session->seal(plaintext, output)) {
+            return false;
+        }
+        output.push_back('\n');
+        return true;
+    }
+    return finishEnvelope();
+}
+
+bool MessageEncoder::finishEnvelope() {
+    if (!ready) {
+        return false;
+    }
+
+    unsigned char iv[16];
+    if (!CryptoUtils::fillRandomBytes(iv, sizeof(iv))) {
+        std::cerr << "[ERROR] Error al generar IV" << std::endl;
+        return false;
+    }
+
+    // AES-256-CBC sobre el búfer de trabajo (resize no reserva si ya tiene capacidad)
+    ciphertext.resize(plaintext.size() + 16);
+    int len = 0;
+    int finalLen = 0;
+    if (EVP_EncryptInit_ex(cipher, NULL, NULL, NULL, iv) != 1 ||
+        EVP_EncryptUpdate(cipher, ciphertext.data(), &len,
+                          reinterpret_cast<const unsigned char*>(plaintext.data()), plaintext.size()) != 1 ||
+        EVP_EncryptFinal_ex(cipher, ciphertext.data() + len, &finalLen) != 1) {
+        ERR_print_errors_fp(stderr);
+        std::cerr << "[ERROR] Error al cifrar datos" << std::endl;
+        return false;
+    }
+    size_t ciphertextLength = static_cast<size_t>(len + finalLen);
+
+    // IV_BASE64 ':' DATOS_BASE64 ':' HMAC_HEX '\n', escrito en su lugar
+    static const size_t HMAC_HEX_LENGTH = 64;
+    size_t ivLength = CryptoUtils::base64EncodedLength(sizeof(iv));
+    size_t dataLength = CryptoUtils::base64EncodedLength(ciphertextLength);
+    size_t signedLength = ivLength + 1 + dataLength;
+    output.resize(signedLength + 1 + HMAC_HEX_LENGTH + 1);
+
+    char* out = &output[0];
+    CryptoUtils::base64Encode(iv, sizeof(iv), out);
+    out[ivLength] = ':';
+    CryptoUtils::base64Encode(ciphertext.data(), ciphertextLength, out + ivLength + 1);
+    out[signedLength] = ':';
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    size_t digestLength = 0;
+    if (EVP_MAC_init(mac, NULL, 0, NULL) != 1 ||
+        EVP_MAC_update(mac, reinterpret_cast<const unsigned char*>(out), signedLength) != 1 ||
+        EVP_MAC_final(mac, digest, &digestLength, sizeof(digest)) != 1 ||
+        digestLength * 2 != HMAC_HEX_LENGTH) {
+        ERR_print_errors_fp(stderr);
+        std::cerr << "[ERROR] Error al generar HMAC" << std::endl;
+        return false;
+    }
+
+    static const char hex[] = "0123456789abcdef";
+    char* tag = out + signedLength + 1;
+    for (size_t i = 0; i < digestLength; i++) {
+        tag[2 * i] = hex[digest[i] >> 4];
+        tag[2 * i + 1] = hex[digest[i] & 0x0f];
+    }
+    tag[HMAC_HEX_LENGTH] = '\n';
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef MESSAGE_ENCODER_H
+#define MESSAGE_ENCODER_H
+
+#include <string>
+#include <vector>
+#include <openssl/evp.h>
+#include "crypto_utils.h"
+
+// Arma los mensajes "IV:DATOS_CIFRADOS:HMAC\n" sobre búferes reutilizables.
+// El texto plano se serializa en un búfer de trabajo, se cifra con un contexto AES
+// cuya clave se expande una sola vez y el Base64 y el HMAC se escriben directamente
+// en el búfer de salida: una vez que los búferes alcanzaron el tamaño de los
+// mensajes, armar un mensaje no reserva memoria.
+class MessageEncoder {
+public:
+    MessageEncoder(const std::string& aesKey, const std::string& secretKey);
+    ~MessageEncoder();
+
+    MessageEncoder(const MessageEncoder&) = delete;
+    MessageEncoder& operator=(const MessageEncoder&) = delete;
+
+    // Vacía y devuelve el búfer de texto plano para serializar el siguiente mensaje
+    std::string& beginPlaintext();
+
+    // Cifra el texto plano actual hacia wire(). Con una sesión establecida usa su
+    // clave (AES-GCM + secuencia); si no, el sobre AES-CBC + HMAC.
+    bool finish(SecureSession* session = nullptr);
+
+    // Mensaje listo para enviar, con el terminador '\n'; válido hasta el próximo finish()
+    const std::string& wire() const { return output; }
+
+private:
+    bool finishEnvelope();
+
+    EVP_CIPHER_CTX* cipher;
+    EVP_MAC_CTX* mac;
+    bool ready;
+
+    std::string plaintext;
+    std::vector<unsigned char> ciphertext;
+    std::string output;
+};
+
+#endif // MESSAGE_ENCODER_H
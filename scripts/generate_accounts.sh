@@ -0,0 +1,86 @@
+#!/bin/bash
+
+# Generador de archivos de cuentas para pruebas de carga (ACCOUNTS_FILE del servidor)
+# Autor: Equipo de Desarrollo
+# Versión: 1.0
+
+set -e
+
+# Colores para output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+log_info() {
+    echo -e "${BLUE}[INFO]${NC} $1"
+}
+
+log_success() {
+    echo -e "${GREEN}[SUCCESS]${NC} $1"
+}
+
+log_error() {
+    echo -e "${RED}[ERROR]${NC} $1"
+}
+
+show_help() {
+    echo "=== GENERADOR DE CUENTAS - SISTEMA DE TRANSACCIONES SEGURAS ==="
+    echo ""
+    echo "Uso: $0 <cantidad> <archivo> [csv|bin]"
+    echo ""
+    echo "Genera <cantidad> cuentas de 16 dígitos con saldos entre \$0 y \$10000."
+    echo "  csv  cuenta,saldo por línea (por defecto)"
+    echo "  bin  formato binario TXACCT01 (requiere python3)"
+    echo ""
+    echo "EJEMPLOS:"
+    echo "  $0 1000000 cuentas.csv"
+    echo "  $0 5000000 cuentas.bin bin"
+    echo ""
+}
+
+if [[ $# -lt 2 || "$1" == "-h" || "$1" == "--help" ]]; then
+    show_help
+    exit 0
+fi
+
+COUNT=$1
+OUTPUT=$2
+FORMAT=${3:-csv}
+
+if ! [[ "$COUNT" =~ ^[0-9]+$ ]]; then
+    log_error "Cantidad inválida: $COUNT"
+    exit 1
+fi
+
+log_info "Generando $COUNT cuentas en $OUTPUT ($FORMAT)..."
+
+case $FORMAT in
+    csv)
+        awk -v n="$COUNT" 'BEGIN {
+            srand(42);
+            print "cuenta,saldo";
+            for (i = 0; i < n; i++) {
+                printf "4%015d,%.2f\n", i, rand() * 10000;
+            }
+        }' > "$OUTPUT"
+        ;;
+    bin)
+        python3 - "$COUNT" "$OUTPUT" <<'EOF'
+import random, struct, sys
+count, path = int(sys.argv[1]), sys.argv[2]
+random.seed(42)
+with open(path, 'wb') as out:
+    out.write(b'TXACCT01')
+    for i in range(count):
+        account = b'%016d' % (4000000000000000 + i)
+        out.write(struct.pack('<24sd', account, round(random.random() * 10000, 2)))
+EOF
+        ;;
+    *)
+        log_error "Formato no soportado: $FORMAT"
+        exit 1
+        ;;
+esac
+
+log_success "Archivo generado: $OUTPUT ($(du -h "$OUTPUT" | cut -f1))"
@@ -0,0 +1,225 @@
+#!/bin/bash
+
+# Prueba local del traspaso del socket de escucha (HANDOFF_SOCKET) y del drenaje:
+# un proceso nuevo toma el puerto mientras un cliente consulta sin pausa (ninguna
+# consulta debe fallar), el anterior cierra su conexión en espera, termina con
+# código 0 y el nuevo recupera y ejecuta una transacción programada. Luego se
+# detiene el proceso nuevo con SIGTERM mientras una conexión no lee sus respuestas
+# (el servidor queda bloqueado en send): debe terminar con código 0 dentro de
+# DRAIN_TIMEOUT_MS más el segundo de gracia, sea porque el corte de la lectura
+# libera el envío (Linux reciente) o porque vence el plazo y se corta la conexión.
+# Uso: ./scripts/test_handoff_drain.sh
+
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+PORT=18540
+ADMIN=18541
+METRICS=18542
+DRAIN_MS=1000
+BUILD_DIR="$(mktemp -d)"
+HANDOFF="$BUILD_DIR/control.sock"
+SCHEDULE_LOG="$BUILD_DIR/programadas.log"
+OLD_PID=""
+NEW_PID=""
+FAILED=0
+
+FROM=1234567890123456
+TO=6543210987654321
+
+log_info() {
+    echo -e "${BLUE}[INFO]${NC} $1"
+}
+
+log_pass() {
+    echo -e "${GREEN}[PASS]${NC} $1"
+}
+
+log_fail() {
+    echo -e "${RED}[FAIL]${NC} $1"
+    FAILED=1
+}
+
+cleanup() {
+    for pid in "$OLD_PID" "$NEW_PID"; do
+        if [ -n "$pid" ]; then
+            kill -KILL "$pid" 2>/dev/null || true
+            wait "$pid" 2>/dev/null || true
+        fi
+    done
+    jobs -p | xargs -r kill 2>/dev/null || true
+    rm -rf "$BUILD_DIR"
+}
+trap cleanup EXIT
+
+# Arranca un servidor con el socket de control y deja su PID en STARTED_PID
+start_server() {
+    local log="$1"
+    HANDOFF_SOCKET="$HANDOFF" SCHEDULE_FILE="$SCHEDULE_LOG" DRAIN_TIMEOUT_MS="$DRAIN_MS" \
+        ADMIN_PORT="$ADMIN" METRICS_PORT="$METRICS" "$BUILD_DIR/servidor" "$PORT" > "$log" 2>&1 &
+    STARTED_PID=$!
+    for _ in $(seq 1 50); do
+        curl -sf "localhost:$ADMIN/status" > /dev/null 2>&1 && return
+        sleep 0.1
+    done
+    log_fail "El servidor no respondió al arrancar"
+}
+
+# Espera a que termine un servidor y deja su código de salida en EXIT_CODE (255 si
+# no termina en 10 s)
+wait_exit() {
+    local pid="$1"
+    EXIT_CODE=255
+    for _ in $(seq 1 100); do
+        if ! kill -0 "$pid" 2>/dev/null; then
+            EXIT_CODE=0
+            wait "$pid" || EXIT_CODE=$?
+            return
+        fi
+        sleep 0.1
+    done
+}
+
+# Conexión en espera de un mensaje: escribe en $2 los milisegundos hasta que el servidor la cierra
+idle_connection() {
+    python3 - "$PORT" "$1" <<'EOF'
+import socket, sys, time
+
+sock = socket.create_connection(("127.0.0.1", int(sys.argv[1])))
+start = time.monotonic()
+sock.settimeout(10)
+try:
+    while sock.recv(65536):
+        pass
+except OSError:
+    pass
+with open(sys.argv[2], "w") as out:
+    out.write(str(int((time.monotonic() - start) * 1000)))
+EOF
+}
+
+# Envía miles de mensajes sin leer las respuestas y mantiene la conexión abierta:
+# el servidor queda bloqueado en send
+unread_connection() {
+    python3 - "$PORT" <<'EOF'
+import socket, sys, time
+
+sock = socket.create_connection(("127.0.0.1", int(sys.argv[1])))
+sock.settimeout(5)
+try:
+    sock.sendall(b"x\n" * 500000)
+except OSError:
+    pass
+time.sleep(10)
+EOF
+}
+
+run_client() {
+    "$BUILD_DIR/cliente" 127.0.0.1 "$PORT" "$@" 2>&1
+}
+
+log_info "Compilando servidor y cliente..."
+make -s -C "$ROOT_DIR/servidor" TARGET="$BUILD_DIR/servidor" > /dev/null
+make -s -C "$ROOT_DIR/cliente" TARGET="$BUILD_DIR/cliente" > /dev/null
+
+log_info "Arrancando el proceso anterior..."
+start_server "$BUILD_DIR/anterior.log"
+OLD_PID=$STARTED_PID
+if run_client schedule +3 transfer 100.00 "$FROM" "$TO" | grep -q "SCHEDULED"; then
+    log_pass "Transferencia programada en el proceso anterior"
+else
+    log_fail "No se pudo programar la transferencia"
+fi
+
+idle_connection "$BUILD_DIR/espera.ms" &
+IDLE_PID=$!
+(
+    failures=0
+    for _ in $(seq 1 100); do
+        run_client balance "$FROM" | grep -q "Transacción procesada exitosamente" || failures=$((failures + 1))
+    done
+    echo "$failures" > "$BUILD_DIR/fallidas"
+) &
+QUERIES_PID=$!
+sleep 0.3
+
+log_info "Arrancando el proceso nuevo con el mismo HANDOFF_SOCKET..."
+start_server "$BUILD_DIR/nuevo.log"
+NEW_PID=$STARTED_PID
+
+wait_exit "$OLD_PID"
+OLD_PID=""
+if [ "$EXIT_CODE" -eq 0 ] && grep -q "Socket de escucha traspasado" "$BUILD_DIR/anterior.log"; then
+    log_pass "El proceso anterior traspasó el socket y terminó con código 0"
+else
+    log_fail "El proceso anterior terminó con código $EXIT_CODE"
+    tail -5 "$BUILD_DIR/anterior.log"
+fi
+if grep -q "Socket de escucha recibido del proceso anterior" "$BUILD_DIR/nuevo.log"; then
+    log_pass "El proceso nuevo recibió el socket de escucha"
+else
+    log_fail "El proceso nuevo no recibió el socket de escucha"
+fi
+
+wait "$IDLE_PID" || true
+waited=$(cat "$BUILD_DIR/espera.ms" 2>/dev/null || echo 99999)
+if [ "$waited" -lt "$DRAIN_MS" ]; then
+    log_pass "La conexión en espera se cerró al drenar ($waited ms)"
+else
+    log_fail "La conexión en espera tardó $waited ms en cerrarse"
+fi
+
+wait "$QUERIES_PID" || true
+failures=$(cat "$BUILD_DIR/fallidas" 2>/dev/null || echo 100)
+if [ "$failures" -eq 0 ]; then
+    log_pass "100 consultas durante el traspaso, ninguna fallida"
+else
+    log_fail "$failures de 100 consultas fallaron durante el traspaso"
+fi
+
+if grep -q "Transacciones programadas recuperadas de $SCHEDULE_LOG: 1" "$BUILD_DIR/nuevo.log"; then
+    log_pass "El proceso nuevo recuperó la transferencia programada"
+else
+    log_fail "El proceso nuevo no recuperó la transferencia programada"
+fi
+for _ in $(seq 1 60); do
+    grep -q "transacciones programadas ejecutadas" "$BUILD_DIR/nuevo.log" && break
+    sleep 0.1
+done
+# Los saldos no se traspasan: el proceso nuevo parte de los iniciales
+if run_client balance "$FROM" | grep -qF "Cuenta $FROM: \$4900"; then
+    log_pass "El proceso nuevo ejecutó la transferencia programada"
+else
+    log_fail "El proceso nuevo no ejecutó la transferencia programada"
+fi
+
+log_info "SIGTERM con una conexión que no lee sus respuestas..."
+unread_connection &
+UNREAD_PID=$!
+# Tiempo para que el servidor llene su búfer de envío (unos 4 MB de respuestas)
+sleep 3
+start=$(date +%s%N)
+kill -TERM "$NEW_PID"
+wait_exit "$NEW_PID"
+NEW_PID=""
+elapsed=$((($(date +%s%N) - start) / 1000000))
+if grep -q "Plazo de drenaje vencido" "$BUILD_DIR/nuevo.log"; then
+    how="plazo vencido, conexión cortada"
+else
+    how="la conexión terminó al cortar la lectura"
+fi
+if [ "$EXIT_CODE" -eq 0 ] && [ "$elapsed" -lt $((DRAIN_MS + 1500)) ]; then
+    log_pass "Drenaje con código 0 en $elapsed ms ($how)"
+else
+    log_fail "Drenaje con código $EXIT_CODE en $elapsed ms ($how)"
+    tail -5 "$BUILD_DIR/nuevo.log"
+fi
+kill "$UNREAD_PID" 2>/dev/null || true
+wait "$UNREAD_PID" 2>/dev/null || true
+
+exit $FAILED
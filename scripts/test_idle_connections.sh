@@ -0,0 +1,142 @@
+#!/bin/bash
+
+# Prueba local de los plazos de conexión: con plazos de 500 ms verifica que el
+# servidor cierre una conexión sin mensajes, una con un mensaje a medias y una que
+# no lee sus respuestas, que no cierre una que sigue hablando y que los cierres
+# aparezcan en /status. Las conexiones las abre un script en python3.
+# Uso: ./scripts/test_idle_connections.sh
+
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+PORT=18530
+ADMIN=18531
+METRICS=18532
+TIMEOUT_MS=500
+BUILD_DIR="$(mktemp -d)"
+SERVER_LOG="$BUILD_DIR/servidor.log"
+SERVER_PID=""
+FAILED=0
+
+log_info() {
+    echo -e "${BLUE}[INFO]${NC} $1"
+}
+
+log_pass() {
+    echo -e "${GREEN}[PASS]${NC} $1"
+}
+
+log_fail() {
+    echo -e "${RED}[FAIL]${NC} $1"
+    FAILED=1
+}
+
+cleanup() {
+    if [ -n "$SERVER_PID" ]; then
+        kill "$SERVER_PID" 2>/dev/null || true
+        wait "$SERVER_PID" 2>/dev/null || true
+    fi
+    rm -rf "$BUILD_DIR"
+}
+trap cleanup EXIT
+
+# Abre una conexión y se comporta según el modo; imprime lo observado:
+#   inactiva   no envía nada; milisegundos hasta que el servidor cierra
+#   incompleta envía un mensaje sin terminador; milisegundos hasta el cierre
+#   activa     envía un mensaje cada 300 ms durante 2 s; respuestas recibidas
+#   sin-leer   envía miles de mensajes sin leer las respuestas y espera
+connection() {
+    python3 - "$PORT" "$1" <<'EOF'
+import socket, sys, time
+
+port, mode = int(sys.argv[1]), sys.argv[2]
+sock = socket.create_connection(("127.0.0.1", port))
+start = time.monotonic()
+
+def wait_close():
+    sock.settimeout(5)
+    try:
+        while sock.recv(65536):
+            pass
+    except OSError:
+        pass
+    print(int((time.monotonic() - start) * 1000))
+
+if mode == "inactiva":
+    wait_close()
+elif mode == "incompleta":
+    sock.sendall(b"mensaje sin terminar")
+    wait_close()
+elif mode == "activa":
+    sock.settimeout(2)
+    answered = 0
+    reader = sock.makefile("rb")
+    for _ in range(7):
+        sock.sendall(b"x\n")
+        if reader.readline():
+            answered += 1
+        time.sleep(0.3)
+    print(answered)
+elif mode == "sin-leer":
+    sock.settimeout(3)
+    try:
+        sock.sendall(b"x\n" * 500000)
+    except OSError:
+        pass
+    time.sleep(2)
+EOF
+}
+
+# El cierre debe llegar después del plazo y bastante antes de los 5 s de espera
+check_closed() {
+    local description="$1"
+    local millis="$2"
+    if [ "$millis" -ge $((TIMEOUT_MS - 100)) ] && [ "$millis" -lt 3000 ]; then
+        log_pass "$description - cerrada a los $millis ms"
+    else
+        log_fail "$description - cerrada a los $millis ms (plazo $TIMEOUT_MS ms)"
+    fi
+}
+
+log_info "Compilando servidor..."
+make -s -C "$ROOT_DIR/servidor" TARGET="$BUILD_DIR/servidor" > /dev/null
+
+log_info "Arrancando servidor con plazos de $TIMEOUT_MS ms..."
+IDLE_TIMEOUT_MS="$TIMEOUT_MS" FRAME_TIMEOUT_MS="$TIMEOUT_MS" WRITE_TIMEOUT_MS="$TIMEOUT_MS" \
+    ADMIN_PORT="$ADMIN" METRICS_PORT="$METRICS" "$BUILD_DIR/servidor" "$PORT" > "$SERVER_LOG" 2>&1 &
+SERVER_PID=$!
+for _ in $(seq 1 50); do
+    curl -sf "localhost:$ADMIN/status" > /dev/null 2>&1 && break
+    sleep 0.1
+done
+
+check_closed "Conexión sin mensajes" "$(connection inactiva)"
+check_closed "Mensaje sin terminador" "$(connection incompleta)"
+
+answered=$(connection activa)
+if [ "$answered" -eq 7 ]; then
+    log_pass "Conexión activa durante 2 s - 7 de 7 respuestas"
+else
+    log_fail "Conexión activa durante 2 s - $answered de 7 respuestas"
+fi
+
+connection sin-leer
+sleep 0.5
+
+status=$(curl -sf "localhost:$ADMIN/status" | grep "Cerradas por plazo:" || true)
+if echo "$status" | grep -q "inactividad 1, mensaje 1, envío 1"; then
+    log_pass "/status: $status"
+else
+    log_fail "/status no refleja los cierres esperados: $status"
+fi
+
+if ! kill -0 "$SERVER_PID" 2>/dev/null; then
+    log_fail "El servidor terminó durante la prueba"
+fi
+
+exit $FAILED
@@ -0,0 +1,100 @@
+#!/bin/bash
+
+# Prueba local del ledger por particiones: compila el servidor con las aserciones
+# de la biblioteca estándar (índices fuera de rango abortan), lo arranca con más
+# particiones que cuentas y verifica la auditoría antes y después de transferencias
+# entre particiones.
+# Uso: ./scripts/test_ledger_audit.sh [particiones]
+
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+PARTITIONS="${1:-8}"
+PORT=18480
+ADMIN=18481
+METRICS=18482
+BUILD_DIR="$(mktemp -d)"
+SERVER_LOG="$BUILD_DIR/servidor.log"
+SERVER_PID=""
+FAILED=0
+
+log_info() {
+    echo -e "${BLUE}[INFO]${NC} $1"
+}
+
+log_pass() {
+    echo -e "${GREEN}[PASS]${NC} $1"
+}
+
+log_fail() {
+    echo -e "${RED}[FAIL]${NC} $1"
+    FAILED=1
+}
+
+cleanup() {
+    if [ -n "$SERVER_PID" ]; then
+        kill "$SERVER_PID" 2>/dev/null || true
+        wait "$SERVER_PID" 2>/dev/null || true
+    fi
+    rm -rf "$BUILD_DIR"
+}
+trap cleanup EXIT
+
+check_audit() {
+    local description="$1"
+    local report
+    if ! report=$(curl -sf "localhost:$ADMIN/ledger/audit"); then
+        log_fail "$description - sin respuesta (¿el servidor abortó?)"
+        tail -5 "$SERVER_LOG"
+        return
+    fi
+    local ok
+    ok=$(echo "$report" | grep -c " - OK$" || true)
+    if [ "$ok" -eq "$PARTITIONS" ]; then
+        log_pass "$description - $ok particiones OK"
+    else
+        log_fail "$description - $ok de $PARTITIONS particiones OK"
+        echo "$report"
+    fi
+}
+
+log_info "Compilando servidor y cliente con -D_GLIBCXX_ASSERTIONS..."
+make -s -C "$ROOT_DIR/servidor" TARGET="$BUILD_DIR/servidor" \
+    CXXFLAGS="-std=c++17 -Wall -Wextra -O1 -g -pthread -D_GLIBCXX_ASSERTIONS" > /dev/null
+make -s -C "$ROOT_DIR/cliente" TARGET="$BUILD_DIR/cliente" > /dev/null
+
+log_info "Arrancando servidor con $PARTITIONS particiones y las cuentas de prueba..."
+LEDGER_PARTITIONS="$PARTITIONS" ADMIN_PORT="$ADMIN" METRICS_PORT="$METRICS" \
+    RATE_LIMIT_IP_RPS=0 RATE_LIMIT_ACCOUNT_RPS=0 \
+    "$BUILD_DIR/servidor" "$PORT" > "$SERVER_LOG" 2>&1 &
+SERVER_PID=$!
+for _ in $(seq 1 50); do
+    curl -sf "localhost:$ADMIN/status" > /dev/null 2>&1 && break
+    sleep 0.1
+done
+
+check_audit "Auditoría sin movimientos"
+
+run_client() {
+    if ! "$BUILD_DIR/cliente" 127.0.0.1 "$PORT" "$@" | grep -q "SUCCESS"; then
+        log_fail "cliente $*"
+    fi
+}
+
+for _ in 1 2 3; do
+    run_client transfer 10.00 1234567890123456 6543210987654321
+    run_client transfer 5.00 6543210987654321 1111222233334444
+done
+run_client deposit 20.00 1111222233334444
+check_audit "Auditoría tras transferencias entre particiones"
+
+if ! kill -0 "$SERVER_PID" 2>/dev/null; then
+    log_fail "El servidor terminó durante la prueba"
+fi
+
+exit $FAILED
@@ -0,0 +1,110 @@
+#!/bin/bash
+
+# Prueba local del cliente asíncrono (comando pipeline): muchas consultas por una
+# sola conexión con una ventana menor que la cantidad, y luego con un límite de
+# tasa por cuenta que rechaza una parte intercalada con las aceptadas. Las
+# respuestas SUCCESS se asocian por ID y las ERROR (sin ID) a la más antigua
+# pendiente: si alguna se asociara mal, una SUCCESS llegaría para un ID ya
+# completado y otra consulta quedaría sin respuesta.
+# Uso: ./scripts/test_pipeline.sh [cantidad]
+
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+COUNT="${1:-500}"
+PORT=18510
+ADMIN=18511
+METRICS=18512
+BUILD_DIR="$(mktemp -d)"
+SERVER_LOG="$BUILD_DIR/servidor.log"
+SERVER_PID=""
+FAILED=0
+
+ACCOUNT=1234567890123456
+
+log_info() {
+    echo -e "${BLUE}[INFO]${NC} $1"
+}
+
+log_pass() {
+    echo -e "${GREEN}[PASS]${NC} $1"
+}
+
+log_fail() {
+    echo -e "${RED}[FAIL]${NC} $1"
+    FAILED=1
+}
+
+cleanup() {
+    if [ -n "$SERVER_PID" ]; then
+        kill "$SERVER_PID" 2>/dev/null || true
+        wait "$SERVER_PID" 2>/dev/null || true
+    fi
+    rm -rf "$BUILD_DIR"
+}
+trap cleanup EXIT
+
+# Ejecuta el pipeline; deja el resumen en SUMMARY y falla si hubo respuestas mal asociadas
+run_pipeline() {
+    local description="$1"
+    local output
+    output=$(ASYNC_WINDOW=16 ASYNC_TIMEOUT_MS=2000 "$BUILD_DIR/cliente" 127.0.0.1 "$PORT" \
+        pipeline "$COUNT" "$ACCOUNT" 2>&1)
+    SUMMARY=$(echo "$output" | grep "Exitosas:" || true)
+    if echo "$output" | grep -q "transacción desconocida\|sin transacción pendiente"; then
+        log_fail "$description - respuestas mal asociadas"
+        echo "$output" | grep "WARNING" | head -5
+    fi
+}
+
+summary_count() {
+    echo "$SUMMARY" | sed -n "s/.*$1: \([0-9]*\).*/\1/p"
+}
+
+log_info "Compilando servidor y cliente..."
+make -s -C "$ROOT_DIR/servidor" TARGET="$BUILD_DIR/servidor" > /dev/null
+make -s -C "$ROOT_DIR/cliente" TARGET="$BUILD_DIR/cliente" > /dev/null
+
+log_info "Arrancando servidor..."
+ADMIN_PORT="$ADMIN" METRICS_PORT="$METRICS" "$BUILD_DIR/servidor" "$PORT" > "$SERVER_LOG" 2>&1 &
+SERVER_PID=$!
+for _ in $(seq 1 50); do
+    curl -sf "localhost:$ADMIN/status" > /dev/null 2>&1 && break
+    sleep 0.1
+done
+
+log_info "$COUNT consultas con ventana de 16..."
+run_pipeline "Sin límites"
+if echo "$SUMMARY" | grep -qF "Exitosas: $COUNT, rechazadas: 0, sin respuesta: 0, desconectadas: 0"; then
+    log_pass "Sin límites - $COUNT exitosas"
+else
+    log_fail "Sin límites - $SUMMARY"
+fi
+
+log_info "Límite por cuenta de 500/s con ráfaga de 1 (aceptadas y rechazadas intercaladas)..."
+curl -sf -X POST "localhost:$ADMIN/ratelimit?account_rps=500&account_burst=1" > /dev/null
+run_pipeline "Con límite por cuenta"
+succeeded=$(summary_count Exitosas)
+rejected=$(summary_count rechazadas)
+if [ -n "$succeeded" ] && [ -n "$rejected" ] && [ "$succeeded" -gt 0 ] && [ "$rejected" -gt 0 ] &&
+    [ $((succeeded + rejected)) -eq "$COUNT" ] && echo "$SUMMARY" | grep -qF "sin respuesta: 0, desconectadas: 0"; then
+    log_pass "Con límite por cuenta - $succeeded exitosas y $rejected rechazadas, todas respondidas"
+else
+    log_fail "Con límite por cuenta - $SUMMARY"
+fi
+if grep -q "Límite de tasa excedido para la cuenta $ACCOUNT" "$SERVER_LOG"; then
+    log_pass "El servidor aplicó el límite por cuenta"
+else
+    log_fail "El servidor no aplicó el límite por cuenta"
+fi
+
+if ! kill -0 "$SERVER_PID" 2>/dev/null; then
+    log_fail "El servidor terminó durante la prueba"
+fi
+
+exit $FAILED
@@ -0,0 +1,143 @@
+#!/bin/bash
+
+# Prueba local de las transacciones programadas: programa transferencias con
+# fracciones de centavo, espera su vencimiento y verifica el saldo resultante; luego
+# repite con registro en disco (SCHEDULE_FILE), mata el servidor antes del
+# vencimiento y verifica que el servidor nuevo las recupere y ejecute.
+# Uso: ./scripts/test_scheduled_payments.sh
+
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+PORT=18490
+ADMIN=18491
+METRICS=18492
+BUILD_DIR="$(mktemp -d)"
+SERVER_LOG="$BUILD_DIR/servidor.log"
+SCHEDULE_LOG="$BUILD_DIR/programadas.log"
+SERVER_PID=""
+FAILED=0
+
+# Cuenta con $1500 al arrancar: tras transferir 1499.996 debe quedar exactamente
+# $0.004 (redondeando a centavos quedaría $0)
+SOURCE=1111222233334444
+TARGET=6543210987654321
+
+log_info() {
+    echo -e "${BLUE}[INFO]${NC} $1"
+}
+
+log_pass() {
+    echo -e "${GREEN}[PASS]${NC} $1"
+}
+
+log_fail() {
+    echo -e "${RED}[FAIL]${NC} $1"
+    FAILED=1
+}
+
+stop_server() {
+    local signal="${1:-TERM}"
+    if [ -n "$SERVER_PID" ]; then
+        kill -"$signal" "$SERVER_PID" 2>/dev/null || true
+        wait "$SERVER_PID" 2>/dev/null || true
+        SERVER_PID=""
+    fi
+}
+
+cleanup() {
+    stop_server
+    rm -rf "$BUILD_DIR"
+}
+trap cleanup EXIT
+
+start_server() {
+    env ADMIN_PORT="$ADMIN" METRICS_PORT="$METRICS" "$@" \
+        "$BUILD_DIR/servidor" "$PORT" >> "$SERVER_LOG" 2>&1 &
+    SERVER_PID=$!
+    for _ in $(seq 1 50); do
+        curl -sf "localhost:$ADMIN/status" > /dev/null 2>&1 && return
+        sleep 0.1
+    done
+    log_fail "El servidor no respondió al arrancar"
+}
+
+run_client() {
+    "$BUILD_DIR/cliente" 127.0.0.1 "$PORT" "$@" 2>&1
+}
+
+schedule() {
+    local output
+    output=$(run_client schedule "$@")
+    if echo "$output" | grep -q "SCHEDULED"; then
+        log_pass "Programada: $*"
+    else
+        log_fail "No se pudo programar: $*"
+        echo "$output" | grep "Resultado\|ERROR"
+    fi
+}
+
+check_balance() {
+    local description="$1"
+    local expected="$2"
+    local result
+    result=$(run_client balance "$SOURCE" | grep "Resultado:" || true)
+    if echo "$result" | grep -qF "Cuenta $SOURCE: \$$expected"; then
+        log_pass "$description - saldo \$$expected"
+    else
+        log_fail "$description - se esperaba \$$expected: $result"
+    fi
+}
+
+wait_executed() {
+    local description="$1"
+    for _ in $(seq 1 60); do
+        grep -q "transacciones programadas ejecutadas" "$SERVER_LOG" && break
+        sleep 0.1
+    done
+    if grep -q "transacciones programadas ejecutadas (0 rechazadas)" "$SERVER_LOG"; then
+        log_pass "$description - ejecutadas sin rechazos"
+    else
+        log_fail "$description - no se ejecutaron o hubo rechazos"
+        grep "programada" "$SERVER_LOG" | tail -5
+    fi
+}
+
+log_info "Compilando servidor y cliente..."
+make -s -C "$ROOT_DIR/servidor" TARGET="$BUILD_DIR/servidor" > /dev/null
+make -s -C "$ROOT_DIR/cliente" TARGET="$BUILD_DIR/cliente" > /dev/null
+
+log_info "Programación en memoria..."
+start_server
+schedule +2 transfer 1499.996 "$SOURCE" "$TARGET"
+check_balance "Antes del vencimiento" "1500"
+wait_executed "Tras el vencimiento"
+check_balance "Tras el vencimiento" "0.004"
+stop_server
+
+log_info "Programación con registro en disco y reinicio antes del vencimiento..."
+: > "$SERVER_LOG"
+start_server SCHEDULE_FILE="$SCHEDULE_LOG"
+schedule +3 transfer 1499.996 "$SOURCE" "$TARGET"
+stop_server KILL
+
+start_server SCHEDULE_FILE="$SCHEDULE_LOG"
+if grep -q "Transacciones programadas recuperadas de $SCHEDULE_LOG: 1" "$SERVER_LOG"; then
+    log_pass "Registro reproducido al arrancar"
+else
+    log_fail "No se recuperó la transacción programada"
+fi
+check_balance "Recuperada, antes del vencimiento" "1500"
+wait_executed "Recuperada, tras el vencimiento"
+check_balance "Recuperada, tras el vencimiento" "0.004"
+
+if ! kill -0 "$SERVER_PID" 2>/dev/null; then
+    log_fail "El servidor terminó durante la prueba"
+fi
+
+exit $FAILED
@@ -0,0 +1,191 @@
+#!/bin/bash
+
+# Prueba local de las sesiones seguras (SESSION_KEYS=1): consulta y transferencia
+# dentro de una sesión, un mensaje de sesión alterado en tránsito (debe rechazarse
+# sin mover saldos) y un mensaje repetido (la secuencia ya usada no se ejecuta dos
+# veces). Un proxy en python3 entre cliente y servidor altera o repite el primer
+# mensaje "S:" de la conexión.
+# Uso: ./scripts/test_session_keys.sh
+
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+PORT=18500
+PROXY=18501
+ADMIN=18502
+METRICS=18503
+BUILD_DIR="$(mktemp -d)"
+SERVER_LOG="$BUILD_DIR/servidor.log"
+SERVER_PID=""
+PROXY_PID=""
+FAILED=0
+
+FROM=1234567890123456
+TO=6543210987654321
+
+log_info() {
+    echo -e "${BLUE}[INFO]${NC} $1"
+}
+
+log_pass() {
+    echo -e "${GREEN}[PASS]${NC} $1"
+}
+
+log_fail() {
+    echo -e "${RED}[FAIL]${NC} $1"
+    FAILED=1
+}
+
+cleanup() {
+    for pid in "$PROXY_PID" "$SERVER_PID"; do
+        if [ -n "$pid" ]; then
+            kill "$pid" 2>/dev/null || true
+            wait "$pid" 2>/dev/null || true
+        fi
+    done
+    rm -rf "$BUILD_DIR"
+}
+trap cleanup EXIT
+
+# Proxy de una sola conexión. Modo "alterar": cambia un carácter del primer mensaje
+# de sesión; modo "repetir": lo envía dos veces seguidas.
+start_proxy() {
+    rm -f "$BUILD_DIR/proxy.listo"
+    python3 - "$PROXY" "$PORT" "$1" "$BUILD_DIR/proxy.listo" <<'EOF' &
+import socket, sys, threading, time
+
+listen_port, server_port, mode, ready = int(sys.argv[1]), int(sys.argv[2]), sys.argv[3], sys.argv[4]
+listener = socket.socket()
+listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+listener.bind(("127.0.0.1", listen_port))
+listener.listen(1)
+open(ready, "w").close()
+client, _ = listener.accept()
+server = socket.create_connection(("127.0.0.1", server_port))
+
+def replies():
+    while True:
+        data = server.recv(65536)
+        if not data:
+            break
+        try:
+            client.sendall(data)
+        except OSError:
+            break
+
+threading.Thread(target=replies, daemon=True).start()
+pending, done = b"", False
+while True:
+    data = client.recv(65536)
+    if not data:
+        break
+    pending += data
+    while b"\n" in pending:
+        line, pending = pending.split(b"\n", 1)
+        if line.startswith(b"S:") and not done:
+            done = True
+            if mode == "alterar":
+                i = len(line) - 10
+                line = line[:i] + (b"B" if line[i:i + 1] == b"A" else b"A") + line[i + 1:]
+            elif mode == "repetir":
+                server.sendall(line + b"\n")
+        server.sendall(line + b"\n")
+# Tiempo para que el servidor procese lo recibido antes de cerrar
+time.sleep(0.5)
+EOF
+    PROXY_PID=$!
+    for _ in $(seq 1 50); do
+        [ -f "$BUILD_DIR/proxy.listo" ] && return
+        sleep 0.1
+    done
+    log_fail "El proxy no arrancó"
+}
+
+stop_proxy() {
+    wait "$PROXY_PID" 2>/dev/null || true
+    PROXY_PID=""
+}
+
+run_client() {
+    local port="$1"
+    shift
+    SESSION_KEYS=1 "$BUILD_DIR/cliente" 127.0.0.1 "$port" "$@" 2>&1
+}
+
+check_balance() {
+    local description="$1"
+    local account="$2"
+    local expected="$3"
+    local result
+    result=$(run_client "$PORT" balance "$account" | grep "Resultado:" || true)
+    if echo "$result" | grep -qF "Cuenta $account: \$$expected"; then
+        log_pass "$description - saldo \$$expected"
+    else
+        log_fail "$description - se esperaba \$$expected: $result"
+    fi
+}
+
+log_info "Compilando servidor y cliente..."
+make -s -C "$ROOT_DIR/servidor" TARGET="$BUILD_DIR/servidor" > /dev/null
+make -s -C "$ROOT_DIR/cliente" TARGET="$BUILD_DIR/cliente" > /dev/null
+
+log_info "Arrancando servidor..."
+ADMIN_PORT="$ADMIN" METRICS_PORT="$METRICS" "$BUILD_DIR/servidor" "$PORT" > "$SERVER_LOG" 2>&1 &
+SERVER_PID=$!
+for _ in $(seq 1 50); do
+    curl -sf "localhost:$ADMIN/status" > /dev/null 2>&1 && break
+    sleep 0.1
+done
+
+log_info "Ida y vuelta dentro de una sesión..."
+check_balance "Consulta en sesión" "$FROM" "5000"
+if run_client "$PORT" transfer 10.00 "$FROM" "$TO" | grep -q "Transacción procesada exitosamente"; then
+    log_pass "Transferencia en sesión"
+else
+    log_fail "Transferencia en sesión"
+fi
+check_balance "Origen tras la transferencia" "$FROM" "4990"
+check_balance "Destino tras la transferencia" "$TO" "3010"
+if curl -sf "localhost:$ADMIN/status" | grep -q "Sesiones establecidas: 4"; then
+    log_pass "El servidor contó las 4 sesiones"
+else
+    log_fail "El servidor no contó las sesiones: $(curl -sf "localhost:$ADMIN/status" | grep Sesiones)"
+fi
+
+log_info "Mensaje de sesión alterado en tránsito..."
+start_proxy alterar
+output=$(run_client "$PROXY" transfer 10.00 "$FROM" "$TO")
+stop_proxy
+if echo "$output" | grep -q "Verificación de integridad fallida"; then
+    log_pass "Mensaje alterado rechazado"
+else
+    log_fail "El mensaje alterado no se rechazó: $(echo "$output" | grep "Resultado\|Detalle")"
+fi
+check_balance "Origen tras el mensaje alterado" "$FROM" "4990"
+
+log_info "Mensaje de sesión repetido..."
+start_proxy repetir
+output=$(run_client "$PROXY" transfer 10.00 "$FROM" "$TO")
+stop_proxy
+if echo "$output" | grep -q "Transacción procesada exitosamente"; then
+    log_pass "Primer envío procesado"
+else
+    log_fail "El primer envío no se procesó: $(echo "$output" | grep "Resultado\|Detalle")"
+fi
+if grep -q "Mensaje de sesión rechazado (secuencia" "$SERVER_LOG"; then
+    log_pass "Repetición rechazada por secuencia"
+else
+    log_fail "La repetición no se rechazó"
+fi
+check_balance "Origen tras la repetición (un solo débito)" "$FROM" "4980"
+
+if ! kill -0 "$SERVER_PID" 2>/dev/null; then
+    log_fail "El servidor terminó durante la prueba"
+fi
+
+exit $FAILED
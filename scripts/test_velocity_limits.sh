@@ -0,0 +1,156 @@
+#!/bin/bash
+
+# Prueba local de los límites de velocidad por cuenta: con a lo sumo 3 débitos y
+# $100 por minuto, verifica el rechazo por cantidad y por monto sin tocar el saldo,
+# que los créditos no cuenten y que un lote atómico revertido devuelva sus débitos
+# a los contadores. Se repite con el ledger por particiones (salvo el lote atómico,
+# que ese modo no admite).
+# Uso: ./scripts/test_velocity_limits.sh
+
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+ROOT_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+PORT=18520
+ADMIN=18521
+METRICS=18522
+BUILD_DIR="$(mktemp -d)"
+SERVER_LOG="$BUILD_DIR/servidor.log"
+SERVER_PID=""
+FAILED=0
+
+ACCOUNT_A=1234567890123456
+ACCOUNT_B=6543210987654321
+ACCOUNT_C=1111222233334444
+
+log_info() {
+    echo -e "${BLUE}[INFO]${NC} $1"
+}
+
+log_pass() {
+    echo -e "${GREEN}[PASS]${NC} $1"
+}
+
+log_fail() {
+    echo -e "${RED}[FAIL]${NC} $1"
+    FAILED=1
+}
+
+stop_server() {
+    if [ -n "$SERVER_PID" ]; then
+        kill "$SERVER_PID" 2>/dev/null || true
+        wait "$SERVER_PID" 2>/dev/null || true
+        SERVER_PID=""
+    fi
+}
+
+cleanup() {
+    stop_server
+    rm -rf "$BUILD_DIR"
+}
+trap cleanup EXIT
+
+start_server() {
+    env ADMIN_PORT="$ADMIN" METRICS_PORT="$METRICS" VELOCITY_MINUTE_COUNT=3 VELOCITY_MINUTE_AMOUNT=100 "$@" \
+        "$BUILD_DIR/servidor" "$PORT" > "$SERVER_LOG" 2>&1 &
+    SERVER_PID=$!
+    for _ in $(seq 1 50); do
+        curl -sf "localhost:$ADMIN/status" > /dev/null 2>&1 && return
+        sleep 0.1
+    done
+    log_fail "El servidor no respondió al arrancar"
+}
+
+# Resultado o detalle del error de un comando del cliente
+run_client() {
+    "$BUILD_DIR/cliente" 127.0.0.1 "$PORT" "$@" 2>&1 | grep "Resultado:\|Detalle:" || true
+}
+
+expect_accepted() {
+    local description="$1"
+    shift
+    local result
+    result=$(run_client "$@")
+    if echo "$result" | grep -q "SUCCESS"; then
+        log_pass "$description"
+    else
+        log_fail "$description: $result"
+    fi
+}
+
+expect_velocity() {
+    local description="$1"
+    shift
+    local result
+    result=$(run_client "$@")
+    if echo "$result" | grep -q "Límite de velocidad excedido (minuto)"; then
+        log_pass "$description"
+    else
+        log_fail "$description - se esperaba el límite por minuto: $result"
+    fi
+}
+
+check_balance() {
+    local description="$1"
+    local account="$2"
+    local expected="$3"
+    local result
+    result=$(run_client balance "$account")
+    if echo "$result" | grep -qF "Cuenta $account: \$$expected"; then
+        log_pass "$description - saldo \$$expected"
+    else
+        log_fail "$description - se esperaba \$$expected: $result"
+    fi
+}
+
+check_limits() {
+    expect_accepted "Débito 1 de 3" transfer 10.00 "$ACCOUNT_A" "$ACCOUNT_B"
+    expect_accepted "Débito 2 de 3" transfer 10.00 "$ACCOUNT_A" "$ACCOUNT_B"
+    expect_accepted "Débito 3 de 3" transfer 10.00 "$ACCOUNT_A" "$ACCOUNT_B"
+    expect_velocity "Cuarto débito rechazado por cantidad" transfer 10.00 "$ACCOUNT_A" "$ACCOUNT_B"
+    check_balance "El débito rechazado no tocó el saldo" "$ACCOUNT_A" "4970"
+    expect_accepted "Los créditos no cuentan" deposit 10.00 "$ACCOUNT_A"
+
+    expect_accepted "Débito de \$60" transfer 60.00 "$ACCOUNT_B" "$ACCOUNT_C"
+    expect_velocity "Débito de \$50 rechazado por monto" transfer 50.00 "$ACCOUNT_B" "$ACCOUNT_C"
+    expect_accepted "Débito de \$30 dentro del monto" transfer 30.00 "$ACCOUNT_B" "$ACCOUNT_C"
+    check_balance "Saldo tras los débitos por monto" "$ACCOUNT_B" "2940"
+
+    if curl -sf "localhost:$ADMIN/status" | grep -q "Débitos rechazados: 2"; then
+        log_pass "/status cuenta los 2 rechazos"
+    else
+        log_fail "/status no cuenta los rechazos: $(curl -sf "localhost:$ADMIN/status" | grep -i velocidad)"
+    fi
+}
+
+log_info "Compilando servidor y cliente..."
+make -s -C "$ROOT_DIR/servidor" TARGET="$BUILD_DIR/servidor" > /dev/null
+make -s -C "$ROOT_DIR/cliente" TARGET="$BUILD_DIR/cliente" > /dev/null
+
+log_info "Saldos con locks..."
+start_server
+check_limits
+
+log_info "Lote atómico revertido..."
+BATCH_FILE="$BUILD_DIR/lote.txt"
+printf 'transfer 10.00 %s %s\ntransfer 10.00 %s %s\ntransfer 99999.00 %s %s\n' \
+    "$ACCOUNT_C" "$ACCOUNT_A" "$ACCOUNT_C" "$ACCOUNT_A" "$ACCOUNT_C" "$ACCOUNT_A" > "$BATCH_FILE"
+"$BUILD_DIR/cliente" 127.0.0.1 "$PORT" batch "$BATCH_FILE" atomico > /dev/null 2>&1 || true
+check_balance "El lote revertido no tocó el saldo" "$ACCOUNT_C" "1590"
+expect_accepted "Débito 1 de 3 tras el lote revertido" transfer 5.00 "$ACCOUNT_C" "$ACCOUNT_A"
+expect_accepted "Débito 2 de 3 tras el lote revertido" transfer 5.00 "$ACCOUNT_C" "$ACCOUNT_A"
+expect_accepted "Débito 3 de 3 tras el lote revertido" transfer 5.00 "$ACCOUNT_C" "$ACCOUNT_A"
+stop_server
+
+log_info "Ledger por particiones..."
+start_server LEDGER_PARTITIONS=4
+check_limits
+if ! kill -0 "$SERVER_PID" 2>/dev/null; then
+    log_fail "El servidor terminó durante la prueba"
+fi
+
+exit $FAILED
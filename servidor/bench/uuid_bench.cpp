@@ -0,0 +1,97 @@
+// Comparación de la generación de UUID: la implementación anterior (random_device y
+// mt19937 por llamada, dígitos por stringstream) contra el generador xoshiro256**
+// por hilo de CryptoUtils. Uso: make bench [BENCH_ITERATIONS=N]
+#include "../src/crypto_utils.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// Copia de CryptoUtils::generateUUID antes del generador por hilo
+std::string previousGenerateUUID() {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<> dis(0, 15);
+    std::uniform_int_distribution<> dis2(8, 11);
+
+    std::stringstream ss;
+    int i;
+    ss << std::hex;
+    for (i = 0; i < 8; i++) {
+        ss << dis(gen);
+    }
+    ss << "-";
+    for (i = 0; i < 4; i++) {
+        ss << dis(gen);
+    }
+    ss << "-4";
+    for (i = 0; i < 3; i++) {
+        ss << dis(gen);
+    }
+    ss << "-";
+    ss << dis2(gen);
+    for (i = 0; i < 3; i++) {
+        ss << dis(gen);
+    }
+    ss << "-";
+    for (i = 0; i < 12; i++) {
+        ss << dis(gen);
+    }
+    return ss.str();
+}
+
+// Suma de control para que el compilador no descarte los UUID generados
+unsigned checksum = 0;
+
+template <typename Generate>
+double nanosPerCall(size_t iterations, Generate generate) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        generate();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+}
+
+void report(const char* name, double nanos, double baseline) {
+    std::cout << std::left << std::setw(34) << name << std::right << std::setw(10) << std::fixed
+              << std::setprecision(1) << nanos << " ns/UUID";
+    if (baseline > 0) {
+        std::cout << std::setw(10) << std::setprecision(1) << baseline / nanos << "x";
+    }
+    std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    if (iterations == 0) {
+        std::cerr << "[ERROR] Cantidad de iteraciones inválida" << std::endl;
+        return 1;
+    }
+    char buffer[CryptoUtils::UUID_LENGTH];
+
+    // Calentamiento: siembra el generador del hilo y carga las páginas del código
+    CryptoUtils::generateUUID();
+    CryptoUtils::generateUUIDv7();
+
+    std::cout << "=== GENERACIÓN DE UUID (" << iterations << " iteraciones) ===" << std::endl;
+    double previous = nanosPerCall(iterations, [] { checksum += previousGenerateUUID()[0]; });
+    report("anterior (mt19937 + stringstream)", previous, 0);
+    report("v4 en búfer (formatUUIDv4)",
+           nanosPerCall(iterations, [&] { CryptoUtils::formatUUIDv4(buffer); checksum += buffer[0]; }), previous);
+    report("v4 std::string (generateUUID)",
+           nanosPerCall(iterations, [] { checksum += CryptoUtils::generateUUID()[0]; }), previous);
+    report("v7 en búfer (formatUUIDv7)",
+           nanosPerCall(iterations, [&] { CryptoUtils::formatUUIDv7(buffer); checksum += buffer[35]; }), previous);
+    report("v7 std::string (generateUUIDv7)",
+           nanosPerCall(iterations, [] { checksum += CryptoUtils::generateUUIDv7()[35]; }), previous);
+    std::cout << "(suma de control " << checksum << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,275 @@
+#include "account_loader.h"
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <sstream>
+#include <string_view>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+const char BINARY_MAGIC[] = "TXACCT01";
+const size_t BINARY_MAGIC_LENGTH = 8;
+// Por debajo de este tamaño por hilo no compensa repartir el parseo
+const size_t MIN_BYTES_PER_THREAD = 256 * 1024;
+
+struct ParsedAccount {
+    std::string_view account;
+    double balance;
+};
+
+// Tramo del archivo asignado a un hilo; las cuentas apuntan al mapeo, sin copias
+struct Chunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    bool first = false;
+    std::vector<ParsedAccount> accounts;
+    size_t rejected = 0;
+};
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+bool validAccount(std::string_view account) {
+    if (account.empty() || account.size() > AccountLoader::MAX_ACCOUNT_LENGTH) {
+        return false;
+    }
+    for (char c : account) {
+        // El número de cuenta viaja en mensajes separados por '|'
+        if (c <= ' ' || c == '|' || c == ',') {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool validBalance(double balance) {
+    return std::isfinite(balance) && balance >= 0.0;
+}
+
+void parseCsv(Chunk& chunk) {
+    // Estimación de líneas para reservar una sola vez: "cuenta de 16,saldo\n"
+    chunk.accounts.reserve(static_cast<size_t>(chunk.end - chunk.begin) / 24 + 1);
+    bool headerAllowed = chunk.first;
+
+    const char* cursor = chunk.begin;
+    while (cursor < chunk.end) {
+        const char* newline = static_cast<const char*>(memchr(cursor, '\n', chunk.end - cursor));
+        const char* lineEnd = newline ? newline : chunk.end;
+        std::string_view line = trim(std::string_view(cursor, lineEnd - cursor));
+        cursor = newline ? newline + 1 : chunk.end;
+
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+
+        size_t comma = line.find(',');
+        std::string_view account = trim(line.substr(0, comma));
+        std::string_view value = comma == std::string_view::npos ? std::string_view() : trim(line.substr(comma + 1));
+
+        double balance = 0.0;
+        auto parsed = std::from_chars(value.data(), value.data() + value.size(), balance);
+        bool ok = comma != std::string_view::npos && parsed.ec == std::errc() &&
+                  parsed.ptr == value.data() + value.size() && validAccount(account) && validBalance(balance);
+        if (!ok) {
+            // Solo la primera línea útil del archivo puede ser un encabezado
+            if (!headerAllowed) {
+                chunk.rejected++;
+            }
+            headerAllowed = false;
+            continue;
+        }
+        headerAllowed = false;
+        chunk.accounts.push_back(ParsedAccount{account, balance});
+    }
+}
+
+void parseBinary(Chunk& chunk) {
+    size_t records = static_cast<size_t>(chunk.end - chunk.begin) / AccountLoader::RECORD_SIZE;
+    chunk.accounts.reserve(records);
+
+    for (const char* record = chunk.begin; record + AccountLoader::RECORD_SIZE <= chunk.end;
+         record += AccountLoader::RECORD_SIZE) {
+        std::string_view account(record, strnlen(record, AccountLoader::ACCOUNT_FIELD_SIZE));
+
+        unsigned char raw[sizeof(double)];
+        memcpy(raw, record + AccountLoader::ACCOUNT_FIELD_SIZE, sizeof(raw));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        for (size_t i = 0; i < sizeof(raw) / 2; i++) {
+            std::swap(raw[i], raw[sizeof(raw) - 1 - i]);
+        }
+#endif
+        double balance;
+        memcpy(&balance, raw, sizeof(balance));
+
+        if (!validAccount(account) || !validBalance(balance)) {
+            chunk.rejected++;
+            continue;
+        }
+        chunk.accounts.push_back(ParsedAccount{account, balance});
+    }
+}
+
+} // namespace
+
+long AccountLoader::residentBytes() {
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) {
+        return 0;
+    }
+    long pages = 0;
+    long resident = 0;
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(statm);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+size_t AccountLoader::estimateTableBytes(const AccountTable& accounts) {
+    // Cubetas + un nodo por cuenta (siguiente, hash en caché y el par) + claves fuera de SSO
+    const size_t nodeBytes = sizeof(AccountTable::value_type) + 2 * sizeof(void*);
+    size_t total = accounts.bucket_count() * sizeof(void*) + accounts.size() * nodeBytes;
+    std::string probe;
+    for (const auto& entry : accounts) {
+        if (entry.first.capacity() > probe.capacity()) {
+            total += entry.first.capacity() + 1;
+        }
+    }
+    return total;
+}
+
+bool AccountLoader::load(const std::string& path, size_t threads, AccountTable& accounts,
+                         Report& report, std::string& error) {
+    auto started = std::chrono::steady_clock::now();
+    long residentBefore = residentBytes();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "no se pudo abrir " + path + ": " + strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0 || info.st_size <= 0) {
+        error = "archivo de cuentas vacío o ilegible: " + path;
+        close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        error = "no se pudo mapear " + path + ": " + strerror(errno);
+        return false;
+    }
+    madvise(mapped, size, MADV_WILLNEED);
+
+    const char* data = static_cast<const char*>(mapped);
+    const char* end = data + size;
+    report.fileBytes = size;
+    report.binary = size >= BINARY_MAGIC_LENGTH && memcmp(data, BINARY_MAGIC, BINARY_MAGIC_LENGTH) == 0;
+    const char* body = report.binary ? data + BINARY_MAGIC_LENGTH : data;
+
+    if (threads == 0) {
+        unsigned int cores = std::thread::hardware_concurrency();
+        threads = cores ? cores : 4;
+    }
+    threads = std::max<size_t>(1, std::min(threads, static_cast<size_t>(end - body) / MIN_BYTES_PER_THREAD + 1));
+    report.threads = threads;
+
+    // Cortes: en un múltiplo de registro (binario) o después del siguiente '\n' (CSV)
+    std::vector<Chunk> chunks(threads);
+    const char* cursor = body;
+    for (size_t i = 0; i < threads; i++) {
+        Chunk& chunk = chunks[i];
+        chunk.begin = cursor;
+        chunk.first = (i == 0);
+        if (i + 1 == threads) {
+            chunk.end = end;
+        } else if (report.binary) {
+            size_t records = static_cast<size_t>(end - body) / RECORD_SIZE;
+            chunk.end = body + (records * (i + 1) / threads) * RECORD_SIZE;
+        } else {
+            const char* cut = body + static_cast<size_t>(end - body) * (i + 1) / threads;
+            if (cut < cursor) {
+                cut = cursor;
+            }
+            const char* newline = static_cast<const char*>(memchr(cut, '\n', end - cut));
+            chunk.end = newline ? newline + 1 : end;
+        }
+        cursor = chunk.end;
+    }
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; i++) {
+        workers.emplace_back(report.binary ? parseBinary : parseCsv, std::ref(chunks[i]));
+    }
+    report.binary ? parseBinary(chunks[0]) : parseCsv(chunks[0]);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (report.binary && static_cast<size_t>(end - body) % RECORD_SIZE != 0) {
+        report.rejected++; // registro final truncado
+    }
+
+    size_t parsed = 0;
+    for (const Chunk& chunk : chunks) {
+        parsed += chunk.accounts.size();
+        report.rejected += chunk.rejected;
+    }
+
+    // Una sola reserva con el total: la tabla no se redimensiona durante la carga
+    accounts.reserve(accounts.size() + parsed);
+    for (const Chunk& chunk : chunks) {
+        for (const ParsedAccount& entry : chunk.accounts) {
+            auto inserted = accounts.try_emplace(std::string(entry.account));
+            if (!inserted.second) {
+                report.duplicates++;
+            }
+            inserted.first->second.balance = entry.balance;
+        }
+    }
+    report.loaded = parsed - report.duplicates;
+
+    // Las vistas de los tramos apuntan al mapeo: se libera recién ahora
+    chunks.clear();
+    munmap(mapped, size);
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    report.tableBytes = estimateTableBytes(accounts);
+    report.residentDelta = residentBytes() - residentBefore;
+
+    if (accounts.empty()) {
+        error = "el archivo " + path + " no contiene cuentas válidas";
+        return false;
+    }
+    return true;
+}
+
+std::string AccountLoader::describe(const Report& report) {
+    const double MB = 1024.0 * 1024.0;
+    std::stringstream ss;
+    ss.setf(std::ios::fixed);
+    ss.precision(1);
+    ss << report.loaded << " cuentas (" << (report.binary ? "binario" : "CSV") << ", "
+       << report.fileBytes / MB << " MB) en " << report.seconds * 1000.0 << " ms con "
+       << report.threads << " hilos; tabla ~" << report.tableBytes / MB << " MB, memoria residente +"
+       << report.residentDelta / MB << " MB; " << report.rejected << " rechazadas, "
+       << report.duplicates << " duplicadas";
+    return ss.str();
+}
@@ -0,0 +1,46 @@
+#ifndef ACCOUNT_LOADER_H
+#define ACCOUNT_LOADER_H
+
+#include <string>
+#include <cstddef>
+#include "account_record.h"
+
+// Carga masiva de cuentas al arrancar. El archivo se mapea en memoria, se parte en
+// tantos tramos como hilos (cortando en fin de línea o de registro) y cada hilo
+// parsea el suyo con from_chars sin copiar. Después la tabla se dimensiona una sola
+// vez con el total y se llena en una pasada, en el orden del archivo.
+//
+// Formatos, detectados por el encabezado:
+//   CSV:     cuenta,saldo por línea ('#' comenta; un encabezado no numérico se ignora)
+//   Binario: "TXACCT01" seguido de registros de 32 bytes: cuenta de hasta 24 bytes
+//            rellenada con '\0' y saldo double de 8 bytes en little endian
+class AccountLoader {
+public:
+    static const size_t RECORD_SIZE = 32;
+    static const size_t ACCOUNT_FIELD_SIZE = 24;
+    static const size_t MAX_ACCOUNT_LENGTH = 64;
+
+    struct Report {
+        size_t loaded = 0;
+        size_t rejected = 0;   // líneas o registros mal formados
+        size_t duplicates = 0; // cuentas repetidas: queda el último saldo
+        size_t fileBytes = 0;
+        size_t threads = 0;
+        bool binary = false;
+        double seconds = 0.0;
+        size_t tableBytes = 0;  // estimación de la tabla (cubetas, nodos y claves)
+        long residentDelta = 0; // variación de memoria residente del proceso
+    };
+
+    // threads = 0 usa los núcleos disponibles
+    static bool load(const std::string& path, size_t threads, AccountTable& accounts,
+                     Report& report, std::string& error);
+
+    static std::string describe(const Report& report);
+
+private:
+    static long residentBytes();
+    static size_t estimateTableBytes(const AccountTable& accounts);
+};
+
+#endif // ACCOUNT_LOADER_H
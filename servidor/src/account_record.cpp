@@ -0,0 +1,106 @@
+#include "account_record.h"
+#include <functional>
+
+SplitBalance::SplitBalance(double initial, size_t stripes)
+    : stripes(new Stripe[stripes > 0 ? stripes : 1]), count(stripes > 0 ? stripes : 1), owner(std::thread::id()) {
+    this->stripes[0].value.store(initial, std::memory_order_relaxed);
+}
+
+bool SplitBalance::heldByCaller() const {
+    return owner.load(std::memory_order_relaxed) == std::this_thread::get_id();
+}
+
+SplitBalance::Stripe& SplitBalance::stripeForThisThread() {
+    static thread_local size_t hint = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return stripes[hint % count];
+}
+
+void SplitBalance::lockAll() {
+    for (size_t i = 0; i < count; i++) {
+        stripes[i].mutex.lock();
+    }
+}
+
+void SplitBalance::unlockAll() {
+    for (size_t i = count; i > 0; i--) {
+        stripes[i - 1].mutex.unlock();
+    }
+}
+
+double SplitBalance::sumLocked() const {
+    double total = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        total += stripes[i].value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+double SplitBalance::credit(double amount) {
+    Stripe& stripe = stripeForThisThread();
+    if (heldByCaller()) {
+        stripe.value.store(stripe.value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    } else {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.value.store(stripe.value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    return approximate();
+}
+
+bool SplitBalance::debit(double amount, double& balanceAfter) {
+    bool held = heldByCaller();
+    if (!held) {
+        lockAll();
+    }
+    double total = sumLocked();
+    bool ok = total >= amount;
+    if (ok) {
+        // Cualquier franja sirve: lo que importa es la suma, que solo baja bajo todos los locks
+        stripes[0].value.store(stripes[0].value.load(std::memory_order_relaxed) - amount, std::memory_order_relaxed);
+        balanceAfter = total - amount;
+    }
+    if (!held) {
+        unlockAll();
+    }
+    return ok;
+}
+
+void SplitBalance::adjust(double delta) {
+    bool held = heldByCaller();
+    if (!held) {
+        lockAll();
+    }
+    stripes[0].value.store(stripes[0].value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    if (!held) {
+        unlockAll();
+    }
+}
+
+double SplitBalance::read() {
+    if (heldByCaller()) {
+        return sumLocked();
+    }
+    lockAll();
+    double total = sumLocked();
+    unlockAll();
+    return total;
+}
+
+double SplitBalance::approximate() const {
+    return sumLocked();
+}
+
+SplitBalance::Exclusive::Exclusive(SplitBalance& balance) : balance(balance), nested(balance.heldByCaller()) {
+    if (nested) {
+        return;
+    }
+    balance.lockAll();
+    balance.owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+}
+
+SplitBalance::Exclusive::~Exclusive() {
+    if (nested) {
+        return;
+    }
+    balance.owner.store(std::thread::id(), std::memory_order_relaxed);
+    balance.unlockAll();
+}
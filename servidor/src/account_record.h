@@ -0,0 +1,99 @@
+#ifndef ACCOUNT_RECORD_H
+#define ACCOUNT_RECORD_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include "velocity_counters.h"
+
+// Saldo de una cuenta muy acreditada repartido en franjas (una por núcleo, cada
+// una con su lock en su propia línea de caché). Los créditos solo toman la franja
+// del hilo que acredita, así que no compiten entre sí. Los débitos y las
+// consultas toman todas las franjas en orden: ven una foto consistente del saldo
+// y un débito nunca deja la suma en negativo.
+class SplitBalance {
+public:
+    SplitBalance(double initial, size_t stripes);
+
+    SplitBalance(const SplitBalance&) = delete;
+    SplitBalance& operator=(const SplitBalance&) = delete;
+
+    // Devuelve la suma aproximada (sin foto consistente) después del crédito
+    double credit(double amount);
+    // Falla sin modificar nada si el saldo no alcanza
+    bool debit(double amount, double& balanceAfter);
+    // Movimiento sin validar saldo, para revertir operaciones ya aplicadas
+    void adjust(double delta);
+    double read();
+    // Suma sin locks: para estado y respuestas de crédito
+    double approximate() const;
+
+    size_t stripeCount() const { return count; }
+
+    // Toma todas las franjas durante su vida (p. ej. un lote atómico). Mientras
+    // tanto el mismo hilo opera sobre la cuenta sin volver a tomarlas; un Exclusive
+    // anidado en ese hilo no hace nada.
+    class Exclusive {
+    public:
+        explicit Exclusive(SplitBalance& balance);
+        ~Exclusive();
+
+        Exclusive(const Exclusive&) = delete;
+        Exclusive& operator=(const Exclusive&) = delete;
+
+    private:
+        SplitBalance& balance;
+        bool nested;
+    };
+
+private:
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+        std::atomic<double> value{0.0};
+    };
+
+    void lockAll();
+    void unlockAll();
+    bool heldByCaller() const;
+    double sumLocked() const;
+    Stripe& stripeForThisThread();
+
+    std::unique_ptr<Stripe[]> stripes;
+    size_t count;
+    std::atomic<std::thread::id> owner;
+};
+
+// Cuenta del servidor. El saldo simple se protege con el lock del fragmento de la
+// cuenta; cuando la cuenta se divide el saldo pasa a `split` y ya no vuelve.
+struct AccountRecord {
+    double balance = 0.0;
+    std::atomic<SplitBalance*> split{nullptr};
+
+    // Detección de cuentas calientes: créditos en la ventana actual de un segundo,
+    // actualizados bajo el lock del fragmento
+    int64_t creditWindowStart = 0;
+    uint32_t creditsInWindow = 0;
+
+    // Débitos recientes para los límites de velocidad, bajo el mismo lock que el saldo
+    VelocityCounters velocity;
+
+    AccountRecord() = default;
+    ~AccountRecord() { delete split.load(std::memory_order_relaxed); }
+
+    AccountRecord(const AccountRecord&) = delete;
+    AccountRecord& operator=(const AccountRecord&) = delete;
+
+    SplitBalance* splitBalance() const { return split.load(std::memory_order_acquire); }
+};
+
+// Tabla de cuentas: se llena antes de arrancar y después solo se consulta, así
+// que su estructura se lee sin locks
+using AccountTable = std::unordered_map<std::string, AccountRecord>;
+
+#endif // ACCOUNT_RECORD_H
@@ -0,0 +1,232 @@
+#include "connection_reaper.h"
+#include "metrics.h"
+#include <algorithm>
+#include <sstream>
+#include <sys/socket.h>
+
+namespace {
+
+const char* const PHASE_NAMES[ConnectionReaper::PHASES] = {"busy", "inactividad", "mensaje", "envío"};
+
+const Metrics::Timeout PHASE_METRICS[ConnectionReaper::PHASES] = {
+    Metrics::Timeout::Idle, Metrics::Timeout::Idle, Metrics::Timeout::Frame, Metrics::Timeout::Write
+};
+
+} // namespace
+
+ConnectionReaper::Timer::Timer(ConnectionReaper& reaper, int fd) : reaper(reaper), fd(fd) {
+    {
+        std::lock_guard<std::mutex> lock(reaper.mutex);
+        registeredNext = reaper.registered;
+        if (registeredNext) {
+            registeredNext->registeredPrev = this;
+        }
+        reaper.registered = this;
+    }
+    reaper.trackedCount++;
+}
+
+ConnectionReaper::Timer::~Timer() {
+    {
+        std::lock_guard<std::mutex> lock(reaper.mutex);
+        if (scheduled.load() != NEVER) {
+            reaper.unlink(this);
+        }
+        if (registeredPrev) {
+            registeredPrev->registeredNext = registeredNext;
+        } else {
+            reaper.registered = registeredNext;
+        }
+        if (registeredNext) {
+            registeredNext->registeredPrev = registeredPrev;
+        }
+    }
+    reaper.trackedCount--;
+}
+
+void ConnectionReaper::Timer::armAt(Phase phase, uint64_t startedMillis) {
+    uint32_t timeout = reaper.timeout(phase);
+    if (timeout == 0) {
+        // Sin plazo: si sigue enlazada, el reaper la descarta al llegar a su casillero
+        state.store(0);
+        return;
+    }
+    uint64_t deadline = startedMillis + timeout;
+    state.store((deadline << 2) | static_cast<uint64_t>(phase));
+    // Lo habitual es que el plazo nuevo sea posterior: el reaper lo verá al llegar
+    if (tickOf(deadline) < scheduled.load()) {
+        reaper.reschedule(this);
+    }
+}
+
+ConnectionReaper::ConnectionReaper(const Timeouts& timeouts)
+    : timeouts(timeouts), epoch(std::chrono::steady_clock::now()), currentTick(0) {}
+
+ConnectionReaper::~ConnectionReaper() {
+    stop();
+}
+
+void ConnectionReaper::start() {
+    if (!enabled() || running.exchange(true)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        currentTick = nowMillis() / TICK_MILLIS;
+    }
+    thread = std::thread(&ConnectionReaper::run, this);
+}
+
+void ConnectionReaper::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wakeup.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+bool ConnectionReaper::enabled() const {
+    return timeouts.idleMillis > 0 || timeouts.frameMillis > 0 || timeouts.writeMillis > 0;
+}
+
+uint32_t ConnectionReaper::timeout(Phase phase) const {
+    switch (phase) {
+        case Phase::Idle: return timeouts.idleMillis;
+        case Phase::Frame: return timeouts.frameMillis;
+        case Phase::Write: return timeouts.writeMillis;
+        case Phase::Busy: break;
+    }
+    return 0;
+}
+
+std::string ConnectionReaper::describe() const {
+    std::stringstream ss;
+    if (!enabled()) {
+        ss << "Plazos: sin límites\n";
+    } else {
+        ss << "Plazos (ms): inactividad " << timeouts.idleMillis << ", mensaje " << timeouts.frameMillis
+           << ", envío " << timeouts.writeMillis << " (0 = sin límite)\n";
+    }
+    ss << "Vigiladas: " << tracked() << "\n";
+    ss << "Cerradas por plazo:";
+    for (size_t p = 1; p < PHASES; p++) {
+        ss << " " << PHASE_NAMES[p] << " " << expiredTotals[p].load() << (p + 1 < PHASES ? "," : "\n");
+    }
+    return ss.str();
+}
+
+size_t ConnectionReaper::shutdownAll(int how) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (Timer* timer = registered; timer; timer = timer->registeredNext) {
+        shutdown(timer->fd, how);
+        count++;
+    }
+    return count;
+}
+
+uint64_t ConnectionReaper::nowMillis() const {
+    return toMillis(std::chrono::steady_clock::now());
+}
+
+uint64_t ConnectionReaper::toMillis(std::chrono::steady_clock::time_point time) const {
+    if (time <= epoch) {
+        return 0;
+    }
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(time - epoch).count());
+}
+
+void ConnectionReaper::link(Timer* timer, uint64_t tick) {
+    Timer*& head = slots[tick % SLOTS];
+    timer->prev = nullptr;
+    timer->next = head;
+    if (head) {
+        head->prev = timer;
+    }
+    head = timer;
+    timer->scheduled.store(tick);
+}
+
+void ConnectionReaper::unlink(Timer* timer) {
+    if (timer->prev) {
+        timer->prev->next = timer->next;
+    } else {
+        slots[timer->scheduled.load() % SLOTS] = timer->next;
+    }
+    if (timer->next) {
+        timer->next->prev = timer->prev;
+    }
+    timer->prev = timer->next = nullptr;
+    timer->scheduled.store(NEVER);
+}
+
+// Enlaza la conexión (ya fuera de la rueda) según su plazo vigente o, si venció, la
+// cierra. `scheduled` se publica antes de releer el plazo: un hilo que rearma a la
+// vez ve el casillero nuevo y se mueve él mismo, o el reaper ve su plazo nuevo.
+void ConnectionReaper::place(Timer* timer, uint64_t now) {
+    while (true) {
+        uint64_t state = timer->state.load();
+        if (state == 0) {
+            return;
+        }
+        uint64_t deadline = state >> 2;
+        if (deadline <= now) {
+            // La fase se publica antes del shutdown, que es lo que despierta al hilo
+            size_t phase = static_cast<size_t>(state & 3);
+            timer->expiredPhase.store(static_cast<uint8_t>(phase));
+            timer->state.store(0);
+            shutdown(timer->fd, SHUT_RDWR);
+            expiredTotals[phase]++;
+            Metrics::countTimeout(PHASE_METRICS[phase]);
+            return;
+        }
+        uint64_t tick = std::max(tickOf(deadline), currentTick + 1);
+        timer->scheduled.store(tick);
+        if (timer->state.load() == state) {
+            link(timer, tick);
+            return;
+        }
+    }
+}
+
+void ConnectionReaper::reschedule(Timer* timer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running || timer->expired() != Phase::Busy) {
+        return;
+    }
+    if (timer->scheduled.load() != NEVER) {
+        unlink(timer);
+    }
+    place(timer, nowMillis());
+}
+
+void ConnectionReaper::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        wakeup.wait_for(lock, std::chrono::milliseconds(TICK_MILLIS));
+        uint64_t now = nowMillis();
+        uint64_t nowTick = now / TICK_MILLIS;
+        // Tras una pausa larga alcanza con una vuelta: cada casillero se revisa completo
+        uint64_t from = std::max(currentTick + 1, nowTick >= SLOTS ? nowTick - SLOTS + 1 : 0);
+        for (uint64_t tick = from; tick <= nowTick; tick++) {
+            expireSlot(tick, now);
+        }
+        currentTick = std::max(currentTick, nowTick);
+    }
+}
+
+void ConnectionReaper::expireSlot(uint64_t tick, uint64_t now) {
+    Timer* timer = slots[tick % SLOTS];
+    while (timer) {
+        Timer* next = timer->next;
+        // Las de vueltas posteriores de la rueda comparten casillero y se quedan
+        if (timer->scheduled.load() <= tick) {
+            unlink(timer);
+            place(timer, now);
+        }
+        timer = next;
+    }
+}
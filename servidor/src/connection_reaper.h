@@ -0,0 +1,125 @@
+#ifndef CONNECTION_REAPER_H
+#define CONNECTION_REAPER_H
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Plazos de las conexiones de clientes: inactividad entre mensajes, llegada completa
+// de un mensaje ya empezado (cliente lento estilo slowloris) y envío de la respuesta.
+// Cada conexión se atiende en un hilo bloqueado en recv/send; al vencer un plazo el
+// hilo del reaper hace shutdown del socket, lo que despierta al hilo de la conexión
+// con un error y la cierra por el camino normal.
+//
+// Las conexiones vigiladas viven en una rueda de temporizadores hasheada (SLOTS
+// casilleros de TICK_MILLIS, cada uno una lista doblemente enlazada): agregar, mover
+// o quitar una conexión es O(1) y cada tick recorre solo un casillero. Rearmar un
+// plazo es un store atómico sin lock mientras el nuevo vencimiento no sea anterior al
+// casillero donde está enlazada; si lo es, se mueve bajo el lock de la rueda. Al
+// llegar a su casillero el reaper relee el plazo vigente y la reubica si se corrió.
+class ConnectionReaper {
+public:
+    // Busy = sin plazo (la conexión espera a la cola de trabajo, no al cliente)
+    enum class Phase : uint8_t { Busy, Idle, Frame, Write };
+    static const size_t PHASES = 4;
+
+    // En milisegundos; 0 = sin límite para esa fase
+    struct Timeouts {
+        uint32_t idleMillis = 0;
+        uint32_t frameMillis = 0;
+        uint32_t writeMillis = 0;
+    };
+
+    static const size_t SLOTS = 512;
+    static const uint64_t TICK_MILLIS = 100;
+
+    // Plazo de una conexión. Lo crea el hilo que la atiende y debe destruirse antes
+    // de cerrar el socket: después de la baja el reaper ya no puede tocar el fd.
+    class Timer {
+    public:
+        Timer(ConnectionReaper& reaper, int fd);
+        ~Timer();
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+        // Fija el plazo de `phase` contado desde ahora
+        void arm(Phase phase) { armAt(phase, reaper.nowMillis()); }
+        // Ídem contado desde `startedMillis` (ms de nowMillis())
+        void armAt(Phase phase, uint64_t startedMillis);
+        // Fase cuyo plazo venció y cerró la conexión, o Busy si no venció ninguno
+        Phase expired() const { return static_cast<Phase>(expiredPhase.load()); }
+
+    private:
+        friend class ConnectionReaper;
+
+        ConnectionReaper& reaper;
+        int fd;
+        std::atomic<uint64_t> state{0};         // (vencimiento_ms << 2) | fase; 0 = sin plazo
+        std::atomic<uint64_t> scheduled{NEVER}; // tick del casillero donde está enlazado
+        std::atomic<uint8_t> expiredPhase{0};
+        Timer* prev = nullptr;                  // lista del casillero, bajo el lock de la rueda
+        Timer* next = nullptr;
+        Timer* registeredPrev = nullptr;        // todas las conexiones, bajo el mismo lock
+        Timer* registeredNext = nullptr;
+    };
+
+    explicit ConnectionReaper(const Timeouts& timeouts);
+    ~ConnectionReaper();
+
+    ConnectionReaper(const ConnectionReaper&) = delete;
+    ConnectionReaper& operator=(const ConnectionReaper&) = delete;
+
+    void start();
+    void stop();
+
+    bool enabled() const;
+    uint32_t timeout(Phase phase) const;
+    uint64_t expiredCount(Phase phase) const { return expiredTotals[static_cast<size_t>(phase)].load(); }
+    uint64_t tracked() const { return trackedCount.load(); }
+    std::string describe() const;
+
+    // shutdown(`how`) de todas las conexiones registradas, con o sin plazo; para el
+    // drenaje al detener el servidor. Devuelve cuántas había.
+    size_t shutdownAll(int how);
+
+    // Milisegundos de un reloj monótono desde la creación del reaper
+    uint64_t nowMillis() const;
+    // Convierte un instante del reloj monótono a la escala de nowMillis()
+    uint64_t toMillis(std::chrono::steady_clock::time_point time) const;
+
+private:
+    static const uint64_t NEVER = UINT64_MAX;
+
+    static uint64_t tickOf(uint64_t millis) { return (millis + TICK_MILLIS - 1) / TICK_MILLIS; }
+
+    // Requieren `mutex`
+    void link(Timer* timer, uint64_t tick);
+    void unlink(Timer* timer);
+    void place(Timer* timer, uint64_t now);
+
+    void reschedule(Timer* timer);
+    void run();
+    void expireSlot(uint64_t tick, uint64_t now);
+
+    Timeouts timeouts;
+    std::chrono::steady_clock::time_point epoch;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    Timer* slots[SLOTS] = {};
+    Timer* registered = nullptr;
+    uint64_t currentTick; // último tick procesado
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+
+    std::atomic<uint64_t> trackedCount{0};
+    std::atomic<uint64_t> expiredTotals[PHASES] = {};
+};
+
+#endif // CONNECTION_REAPER_H
@@ -0,0 +1,153 @@
+#ifndef FRAME_IO_H
+#define FRAME_IO_H
+
+#include <string>
+#include <string_view>
+#include <chrono>
+#include <functional>
+#include <cstring>
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+// Lectura de mensajes terminados en '\n' sobre un socket de flujo. Un recv puede
+// traer medio mensaje o varios; el lector acumula en un búfer propio que conserva
+// su capacidad entre mensajes (y entre conexiones con reset), sin limpiarlo en cada
+// lectura. Compartido entre cliente y servidor: mantener ambas copias iguales.
+class FrameReader {
+public:
+    enum class Status {
+        Frame,    // `frame` contiene un mensaje completo, sin el terminador
+        Again,    // socket no bloqueante sin más datos por ahora
+        Closed,   // el otro extremo cerró la conexión
+        Error,    // error de recv
+        TooLarge  // el mensaje pendiente supera el máximo permitido
+    };
+
+    explicit FrameReader(int fd = -1, size_t maxFrameBytes = 4 * 1024 * 1024)
+        : fd(fd), maxFrameBytes(maxFrameBytes), start(0), end(0), scanned(0) {}
+
+    // Asocia otro socket descartando datos pendientes; la capacidad del búfer se conserva
+    void reset(int newFd) {
+        fd = newFd;
+        start = end = scanned = 0;
+    }
+
+    // Se invoca al llegar el primer byte de cada mensaje (p. ej. para pasar del plazo
+    // de inactividad al de recepción del mensaje)
+    void onMessageStart(std::function<void()> handler) {
+        messageStarted = std::move(handler);
+    }
+
+    // Devuelve el siguiente mensaje. La vista es válida hasta la próxima llamada.
+    Status next(std::string_view& frame) {
+        while (true) {
+            size_t from = scanned > start ? scanned : start;
+            const void* newline = from < end ? memchr(&buffer[from], '\n', end - from) : nullptr;
+            if (newline) {
+                size_t pos = static_cast<const char*>(newline) - buffer.data();
+                size_t length = pos - start;
+                if (length > 0 && buffer[pos - 1] == '\r') {
+                    length--;
+                }
+                // Un recv puede traer el mensaje completo de una vez: el límite se
+                // aplica también a los que llegan con su terminador
+                if (length > maxFrameBytes) {
+                    return Status::TooLarge;
+                }
+                frame = std::string_view(buffer.data() + start, length);
+                start = scanned = pos + 1;
+                deliveredSince = pendingSince;
+                if (start < end) {
+                    startMessage();
+                }
+                return Status::Frame;
+            }
+            scanned = end;
+            if (end - start > maxFrameBytes) {
+                return Status::TooLarge;
+            }
+
+            // Compactar: lo ya entregado se descarta antes de leer más
+            if (start > 0) {
+                if (end > start) {
+                    memmove(&buffer[0], &buffer[start], end - start);
+                }
+                end -= start;
+                scanned -= start;
+                start = 0;
+            }
+            if (buffer.size() - end < MIN_READ) {
+                buffer.resize(buffer.size() < INITIAL_SIZE ? INITIAL_SIZE : buffer.size() * 2);
+            }
+
+            ssize_t received = recv(fd, &buffer[end], buffer.size() - end, 0);
+            if (received > 0) {
+                if (end == start) {
+                    startMessage();
+                }
+                end += static_cast<size_t>(received);
+                continue;
+            }
+            if (received == 0) {
+                return Status::Closed;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? Status::Again : Status::Error;
+        }
+    }
+
+    // Momento en que llegó el primer byte del mensaje entregado por el último next()
+    std::chrono::steady_clock::time_point frameStarted() const { return deliveredSince; }
+    // Hay parte de un mensaje ya recibida, que empezó en pendingStarted()
+    bool buffered() const { return end > start; }
+    std::chrono::steady_clock::time_point pendingStarted() const { return pendingSince; }
+
+private:
+    static const size_t INITIAL_SIZE = 4096;
+    static const size_t MIN_READ = 1024;
+
+    void startMessage() {
+        pendingSince = std::chrono::steady_clock::now();
+        if (messageStarted) {
+            messageStarted();
+        }
+    }
+
+    int fd;
+    size_t maxFrameBytes;
+    std::string buffer;
+    size_t start;   // inicio de los datos no entregados
+    size_t end;     // fin de los datos recibidos
+    size_t scanned; // hasta dónde ya se buscó '\n' sin encontrarlo
+    std::chrono::steady_clock::time_point pendingSince;   // primer byte del mensaje en curso
+    std::chrono::steady_clock::time_point deliveredSince; // primer byte del último entregado
+    std::function<void()> messageStarted;
+};
+
+// Escritura completa: send puede aceptar solo parte de los datos
+class FrameWriter {
+public:
+    static bool sendAll(int fd, const char* data, size_t length) {
+        while (length > 0) {
+            ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += sent;
+            length -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    static bool sendAll(int fd, std::string_view data) {
+        return sendAll(fd, data.data(), data.size());
+    }
+};
+
+#endif // FRAME_IO_H
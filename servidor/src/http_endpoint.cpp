@@ -0,0 +1,135 @@
+#include "http_endpoint.h"
+#include <iostream>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+HttpEndpoint::HttpEndpoint(const std::string& name, const std::string& address, int port, Handler handler)
+    : name(name), address(address), port(port), handler(handler), listenSocket(-1), running(false) {}
+
+HttpEndpoint::~HttpEndpoint() {
+    stop();
+}
+
+bool HttpEndpoint::start() {
+    listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenSocket < 0) {
+        std::cerr << "[ERROR] No se pudo crear el socket del endpoint " << name << std::endl;
+        return false;
+    }
+
+    int opt = 1;
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr;
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) <= 0) {
+        std::cerr << "[ERROR] Dirección inválida para el endpoint " << name << ": " << address << std::endl;
+        close(listenSocket);
+        listenSocket = -1;
+        return false;
+    }
+
+    if (bind(listenSocket, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenSocket, 16) < 0) {
+        std::cerr << "[ERROR] No se pudo escuchar en " << address << ":" << port
+                  << " para el endpoint " << name << std::endl;
+        close(listenSocket);
+        listenSocket = -1;
+        return false;
+    }
+
+    running = true;
+    worker = std::thread(&HttpEndpoint::serve, this);
+    std::cout << "[INFO] Endpoint " << name << " escuchando en " << address << ":" << port << std::endl;
+    return true;
+}
+
+void HttpEndpoint::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    shutdown(listenSocket, SHUT_RDWR);
+    close(listenSocket);
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void HttpEndpoint::serve() {
+    while (running) {
+        int clientSocket = accept(listenSocket, nullptr, nullptr);
+        if (clientSocket < 0) {
+            if (!running) {
+                break;
+            }
+            if (errno != EINTR && errno != ECONNABORTED) {
+                // Sin descriptores libres (EMFILE, ENFILE) el error se repite: esperar en vez de girar
+                std::cerr << "[ERROR] Endpoint " << name << ": error al aceptar conexión: " << strerror(errno) << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(ACCEPT_BACKOFF_MILLIS));
+            }
+            continue;
+        }
+        handleConnection(clientSocket);
+        close(clientSocket);
+    }
+}
+
+void HttpEndpoint::handleConnection(int clientSocket) {
+    // Evita que un cliente lento bloquee el endpoint
+    struct timeval timeout = {2, 0};
+    setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(clientSocket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+        ssize_t n = recv(clientSocket, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            break;
+        }
+        request.append(buffer, n);
+    }
+
+    // Línea de petición: "GET /ruta HTTP/1.1"
+    std::string status = "200 OK";
+    std::string body;
+    size_t methodEnd = request.find(' ');
+    size_t pathEnd = methodEnd == std::string::npos ? std::string::npos : request.find(' ', methodEnd + 1);
+    std::string method = request.substr(0, methodEnd == std::string::npos ? 0 : methodEnd);
+    if (pathEnd == std::string::npos || (method != "GET" && method != "POST")) {
+        status = "400 Bad Request";
+        body = "Petición no soportada\n";
+    } else {
+        int code = handler(method, request.substr(methodEnd + 1, pathEnd - methodEnd - 1), body);
+        if (code == NOT_FOUND) {
+            status = "404 Not Found";
+            if (body.empty()) {
+                body = "Ruta no encontrada\n";
+            }
+        } else if (code == METHOD_NOT_ALLOWED) {
+            status = "405 Method Not Allowed";
+            if (body.empty()) {
+                body = "Método no permitido para esta ruta\n";
+            }
+        }
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\n"
+                           "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + body;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = send(clientSocket, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        sent += n;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef HTTP_ENDPOINT_H
+#define HTTP_ENDPOINT_H
+
+#include <string>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+// Listener HTTP mínimo para endpoints de operación (métricas, estado).
+// Atiende una petición GET o POST por conexión desde un único hilo propio, de
+// modo que nunca compite con los hilos que procesan transacciones. Los parámetros
+// van en la ruta; el cuerpo de la petición se ignora.
+class HttpEndpoint {
+public:
+    static const int OK = 200;
+    static const int NOT_FOUND = 404;
+    static const int METHOD_NOT_ALLOWED = 405;
+
+    // Devuelve el código de la respuesta (OK, NOT_FOUND, METHOD_NOT_ALLOWED); con
+    // un error y `body` vacío se responde un mensaje genérico
+    using Handler = std::function<int(const std::string& method, const std::string& path, std::string& body)>;
+
+    HttpEndpoint(const std::string& name, const std::string& address, int port, Handler handler);
+    ~HttpEndpoint();
+
+    bool start();
+    void stop();
+
+private:
+    // Espera tras un accept fallido, para no girar si el error persiste
+    static const int ACCEPT_BACKOFF_MILLIS = 100;
+
+    void serve();
+    void handleConnection(int clientSocket);
+
+    std::string name;
+    std::string address;
+    int port;
+    Handler handler;
+    int listenSocket;
+    std::atomic<bool> running;
+    std::thread worker;
+};
+
+#endif // HTTP_ENDPOINT_H
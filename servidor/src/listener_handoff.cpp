@@ -0,0 +1,163 @@
+#include "listener_handoff.h"
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const char HANDOFF_BYTE = 'L';
+const char RELEASED_BYTE = 'R';
+const int REQUEST_TIMEOUT_SECONDS = 5;
+
+bool makeAddress(const std::string& path, struct sockaddr_un& addr, std::string& error) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        error = "ruta del socket de control demasiado larga: " + path;
+        return false;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+} // namespace
+
+int ListenerHandoff::request(const std::string& path, std::string& error) {
+    struct sockaddr_un addr;
+    if (!makeAddress(path, addr, error)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        error = std::string("socket: ") + strerror(errno);
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        // Sin proceso anterior (o uno que terminó sin borrar su socket): arranque normal
+        if (errno != ENOENT && errno != ECONNREFUSED) {
+            error = "connect " + path + ": " + strerror(errno);
+        }
+        close(fd);
+        return -1;
+    }
+    // Un proceso anterior colgado no debe impedir el arranque
+    struct timeval timeout = {REQUEST_TIMEOUT_SECONDS, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char byte = 0;
+    struct iovec iov = {&byte, 1};
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received != 1 || byte != HANDOFF_BYTE) {
+        error = received < 0 ? std::string("recvmsg: ") + strerror(errno) : "respuesta inválida del proceso anterior";
+        close(fd);
+        return -1;
+    }
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(sizeof(int))) {
+        error = "el proceso anterior no envió el socket de escucha";
+        close(fd);
+        return -1;
+    }
+    int listenFd;
+    memcpy(&listenFd, CMSG_DATA(cmsg), sizeof(listenFd));
+
+    int accepting = 0;
+    socklen_t length = sizeof(accepting);
+    if (getsockopt(listenFd, SOL_SOCKET, SO_ACCEPTCONN, &accepting, &length) < 0 || !accepting) {
+        close(listenFd);
+        close(fd);
+        error = "el descriptor recibido no es un socket de escucha";
+        return -1;
+    }
+
+    // Sin confirmación (el anterior terminó o está colgado) se sigue igual: lo peor es
+    // que un puerto HTTP siga ocupado
+    do {
+        received = recv(fd, &byte, 1, 0);
+    } while (received < 0 && errno == EINTR);
+    close(fd);
+    return listenFd;
+}
+
+int ListenerHandoff::listen(const std::string& path, std::string& error) {
+    struct sockaddr_un addr;
+    if (!makeAddress(path, addr, error)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        error = std::string("socket: ") + strerror(errno);
+        return -1;
+    }
+    unlink(path.c_str());
+    // Sin permisos para el grupo ni otros: quien se conecta se lleva el puerto
+    mode_t previous = umask(0077);
+    int bound = bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    umask(previous);
+    if (bound < 0 || ::listen(fd, 1) < 0) {
+        error = "bind " + path + ": " + strerror(errno);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool ListenerHandoff::send(int peer, int listenFd, std::string& error) {
+    struct ucred credentials;
+    socklen_t length = sizeof(credentials);
+    if (getsockopt(peer, SOL_SOCKET, SO_PEERCRED, &credentials, &length) < 0 || credentials.uid != getuid()) {
+        error = "pedido de traspaso de otro usuario";
+        return false;
+    }
+
+    char byte = HANDOFF_BYTE;
+    struct iovec iov = {&byte, 1};
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &listenFd, sizeof(listenFd));
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(peer, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    if (sent != 1) {
+        error = std::string("sendmsg: ") + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void ListenerHandoff::release(int peer) {
+    char byte = RELEASED_BYTE;
+    ssize_t sent;
+    do {
+        sent = ::send(peer, &byte, 1, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+}
@@ -0,0 +1,32 @@
+#ifndef LISTENER_HANDOFF_H
+#define LISTENER_HANDOFF_H
+
+#include <string>
+
+// Traspaso del socket de escucha a un proceso nuevo, para reiniciar sin cerrar el
+// puerto. El proceso en ejecución atiende un socket Unix de control (HANDOFF_SOCKET);
+// el nuevo se conecta al arrancar y recibe el descriptor con SCM_RIGHTS. Los dos
+// comparten el mismo socket del kernel, así que las conexiones ya encoladas no se
+// pierden: el nuevo empieza a aceptar mientras el anterior drena las suyas y termina.
+//
+// Tras enviar el descriptor el proceso anterior libera lo que no se puede compartir
+// (registro de programadas, puertos HTTP) y lo confirma con release(); el nuevo lo
+// espera antes de abrirlos.
+class ListenerHandoff {
+public:
+    // Proceso nuevo: pide el socket de escucha al proceso que atiende `path` y espera
+    // su confirmación (hasta 5 s). Devuelve -1 con `error` vacío si no hay ninguno
+    // (arranque normal), o -1 con el motivo.
+    static int request(const std::string& path, std::string& error);
+
+    // Proceso en ejecución: socket de control no bloqueante en `path` (reemplaza el de
+    // un proceso anterior); solo el mismo usuario puede conectarse
+    static int listen(const std::string& path, std::string& error);
+
+    // Envía `listenFd` por `peer`, una conexión aceptada del socket de control
+    static bool send(int peer, int listenFd, std::string& error);
+    // Avisa por `peer` que el proceso anterior ya liberó sus recursos
+    static void release(int peer);
+};
+
+#endif // LISTENER_HANDOFF_H
@@ -0,0 +1,214 @@
+#include "metrics.h"
+#include <sstream>
+#include <vector>
+#include <mutex>
+
+namespace {
+
+const int STAGES = static_cast<int>(Metrics::Stage::Count);
+const int REASONS = static_cast<int>(Metrics::ErrorReason::Count);
+const int TX_TYPES = static_cast<int>(Metrics::TxType::Count);
+const int TIMEOUTS = static_cast<int>(Metrics::Timeout::Count);
+
+const char* const STAGE_NAMES[STAGES] = {
+    "frame_read", "queue_wait", "base64_decode", "hmac_verify", "aes_decrypt",
+    "parse", "token_validation", "execute", "response_send"
+};
+
+const char* const REASON_NAMES[REASONS] = {
+    "invalid_format", "invalid_iv", "integrity_check", "decrypt_failed",
+    "invalid_token", "execution_rejected", "internal_error", "busy",
+    "rate_limited"
+};
+
+const char* const TX_TYPE_NAMES[TX_TYPES] = {
+    "TRANSFER", "BALANCE", "PAYMENT", "DEPOSIT", "BATCH", "OTHER"
+};
+
+const char* const TIMEOUT_NAMES[TIMEOUTS] = {"idle", "frame", "write"};
+
+// Límites (en segundos) exportados a Prometheus; se agregan desde los buckets finos
+const double EXPORT_BOUNDS[] = {
+    1e-6, 5e-6, 1e-5, 5e-5, 1e-4, 5e-4, 1e-3, 5e-3, 1e-2, 5e-2, 0.1, 0.5, 1.0, 5.0
+};
+
+// Bloque de contadores de un hilo. Solo su dueño escribe (load + store relajados,
+// sin instrucciones con lock); el exportador lee concurrentemente.
+struct ThreadBlock {
+    std::atomic<uint64_t> buckets[STAGES][Metrics::BUCKETS];
+    std::atomic<uint64_t> sums[STAGES];
+    std::atomic<uint64_t> transactions[TX_TYPES][2];
+    std::atomic<uint64_t> errors[REASONS];
+    std::atomic<uint64_t> timeouts[TIMEOUTS];
+};
+
+inline void bump(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+std::mutex& registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+// Los bloques nunca se liberan: al terminar un hilo su bloque pasa a la lista libre
+// y lo reutiliza otro hilo, conservando los acumulados
+std::vector<ThreadBlock*>& allBlocks() {
+    static std::vector<ThreadBlock*> blocks;
+    return blocks;
+}
+
+std::vector<ThreadBlock*>& freeBlocks() {
+    static std::vector<ThreadBlock*> blocks;
+    return blocks;
+}
+
+struct BlockHolder {
+    ThreadBlock* block = nullptr;
+
+    ~BlockHolder() {
+        if (block) {
+            std::lock_guard<std::mutex> lock(registryMutex());
+            freeBlocks().push_back(block);
+        }
+    }
+};
+
+thread_local BlockHolder localHolder;
+
+ThreadBlock& localBlock() {
+    if (!localHolder.block) {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        if (!freeBlocks().empty()) {
+            localHolder.block = freeBlocks().back();
+            freeBlocks().pop_back();
+        } else {
+            localHolder.block = new ThreadBlock();
+            allBlocks().push_back(localHolder.block);
+        }
+    }
+    return *localHolder.block;
+}
+
+uint64_t load(const std::atomic<uint64_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+int Metrics::bucketIndex(uint64_t nanos) {
+    if (nanos < static_cast<uint64_t>(SUB_BUCKETS)) {
+        return static_cast<int>(nanos);
+    }
+    int exponent = 63 - __builtin_clzll(nanos);
+    int shift = exponent - SUB_BUCKET_BITS;
+    int sub = static_cast<int>((nanos >> shift) & (SUB_BUCKETS - 1));
+    int index = (shift + 1) * SUB_BUCKETS + sub;
+    return index < BUCKETS ? index : BUCKETS - 1;
+}
+
+uint64_t Metrics::bucketUpperBound(int index) {
+    if (index < SUB_BUCKETS) {
+        return static_cast<uint64_t>(index) + 1;
+    }
+    int shift = index / SUB_BUCKETS - 1;
+    uint64_t sub = static_cast<uint64_t>(index % SUB_BUCKETS);
+    return (SUB_BUCKETS + sub + 1) << shift;
+}
+
+void Metrics::recordLatency(Stage stage, uint64_t nanos) {
+    ThreadBlock& block = localBlock();
+    int s = static_cast<int>(stage);
+    bump(block.buckets[s][bucketIndex(nanos)], 1);
+    bump(block.sums[s], nanos);
+}
+
+void Metrics::countTransaction(TxType type, bool success) {
+    bump(localBlock().transactions[static_cast<int>(type)][success ? 1 : 0], 1);
+}
+
+void Metrics::countError(ErrorReason reason) {
+    bump(localBlock().errors[static_cast<int>(reason)], 1);
+}
+
+void Metrics::countTimeout(Timeout timeout) {
+    bump(localBlock().timeouts[static_cast<int>(timeout)], 1);
+}
+
+std::string Metrics::renderPrometheus() {
+    std::vector<ThreadBlock*> blocks;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        blocks = allBlocks();
+    }
+
+    std::stringstream out;
+
+    out << "# HELP transaction_stage_seconds Latencia por etapa del procesamiento de transacciones\n";
+    out << "# TYPE transaction_stage_seconds histogram\n";
+    for (int s = 0; s < STAGES; s++) {
+        std::vector<uint64_t> buckets(BUCKETS, 0);
+        uint64_t sum = 0;
+        for (const ThreadBlock* block : blocks) {
+            for (int b = 0; b < BUCKETS; b++) {
+                buckets[b] += load(block->buckets[s][b]);
+            }
+            sum += load(block->sums[s]);
+        }
+
+        uint64_t cumulative = 0;
+        int b = 0;
+        for (double bound : EXPORT_BOUNDS) {
+            uint64_t boundNanos = static_cast<uint64_t>(bound * 1e9);
+            while (b < BUCKETS && bucketUpperBound(b) <= boundNanos + 1) {
+                cumulative += buckets[b++];
+            }
+            out << "transaction_stage_seconds_bucket{stage=\"" << STAGE_NAMES[s]
+                << "\",le=\"" << bound << "\"} " << cumulative << "\n";
+        }
+        while (b < BUCKETS) {
+            cumulative += buckets[b++];
+        }
+        out << "transaction_stage_seconds_bucket{stage=\"" << STAGE_NAMES[s]
+            << "\",le=\"+Inf\"} " << cumulative << "\n";
+        out << "transaction_stage_seconds_sum{stage=\"" << STAGE_NAMES[s] << "\"} "
+            << static_cast<double>(sum) / 1e9 << "\n";
+        out << "transaction_stage_seconds_count{stage=\"" << STAGE_NAMES[s] << "\"} "
+            << cumulative << "\n";
+    }
+
+    out << "# HELP transactions_total Transacciones procesadas por tipo y resultado\n";
+    out << "# TYPE transactions_total counter\n";
+    for (int t = 0; t < TX_TYPES; t++) {
+        for (int r = 0; r < 2; r++) {
+            uint64_t total = 0;
+            for (const ThreadBlock* block : blocks) {
+                total += load(block->transactions[t][r]);
+            }
+            out << "transactions_total{type=\"" << TX_TYPE_NAMES[t] << "\",result=\""
+                << (r == 1 ? "success" : "error") << "\"} " << total << "\n";
+        }
+    }
+
+    out << "# HELP transaction_errors_total Errores por motivo\n";
+    out << "# TYPE transaction_errors_total counter\n";
+    for (int e = 0; e < REASONS; e++) {
+        uint64_t total = 0;
+        for (const ThreadBlock* block : blocks) {
+            total += load(block->errors[e]);
+        }
+        out << "transaction_errors_total{reason=\"" << REASON_NAMES[e] << "\"} " << total << "\n";
+    }
+
+    out << "# HELP connection_timeouts_total Conexiones cerradas por vencer un plazo\n";
+    out << "# TYPE connection_timeouts_total counter\n";
+    for (int t = 0; t < TIMEOUTS; t++) {
+        uint64_t total = 0;
+        for (const ThreadBlock* block : blocks) {
+            total += load(block->timeouts[t]);
+        }
+        out << "connection_timeouts_total{phase=\"" << TIMEOUT_NAMES[t] << "\"} " << total << "\n";
+    }
+
+    return out.str();
+}
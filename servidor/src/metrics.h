@@ -0,0 +1,100 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Métricas del servidor: histogramas de latencia por etapa y contadores.
+// Cada hilo registra en su propio bloque (sin locks ni operaciones atómicas
+// read-modify-write); el endpoint de métricas suma los bloques al exportar.
+class Metrics {
+public:
+    enum class Stage {
+        FrameRead,
+        QueueWait,
+        Base64Decode,
+        HmacVerify,
+        AesDecrypt,
+        Parse,
+        TokenValidation,
+        Execute,
+        ResponseSend,
+        Count
+    };
+
+    enum class ErrorReason {
+        InvalidFormat,
+        InvalidIV,
+        IntegrityCheck,
+        DecryptFailed,
+        InvalidToken,
+        ExecutionRejected,
+        InternalError,
+        Busy,
+        RateLimited,
+        Count
+    };
+
+    enum class TxType {
+        Transfer,
+        Balance,
+        Payment,
+        Deposit,
+        Batch,
+        Other,
+        Count
+    };
+
+    // Conexiones cerradas por vencer un plazo (ver ConnectionReaper)
+    enum class Timeout {
+        Idle,
+        Frame,
+        Write,
+        Count
+    };
+
+    // Histograma log-lineal estilo HDR: 2^SUB_BUCKET_BITS sub-buckets por potencia de 2
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int EXPONENTS = 40; // hasta ~2^40 ns (~18 minutos)
+    static const int BUCKETS = EXPONENTS * SUB_BUCKETS;
+
+    static void recordLatency(Stage stage, uint64_t nanos);
+    static void countTransaction(TxType type, bool success);
+    static void countError(ErrorReason reason);
+    static void countTimeout(Timeout timeout);
+
+    // Exportación en formato de texto de Prometheus
+    static std::string renderPrometheus();
+
+    static int bucketIndex(uint64_t nanos);
+    static uint64_t bucketUpperBound(int index);
+
+    static uint64_t nowNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+// Mide la duración de una etapa desde la construcción hasta stop() o el destructor
+class StageTimer {
+public:
+    explicit StageTimer(Metrics::Stage stage) : stage(stage), start(Metrics::nowNanos()), stopped(false) {}
+    ~StageTimer() { stop(); }
+
+    void stop() {
+        if (!stopped) {
+            Metrics::recordLatency(stage, Metrics::nowNanos() - start);
+            stopped = true;
+        }
+    }
+
+private:
+    Metrics::Stage stage;
+    uint64_t start;
+    bool stopped;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,94 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// Cola acotada sin locks de varios productores y un solo consumidor, sobre un
+// anillo de capacidad potencia de dos. Cada celda lleva un número de secuencia que
+// indica si está libre para el productor de la vuelta actual o lista para el
+// consumidor, así que encolar es un CAS sobre la cola y desencolar no compite.
+// T debe ser barato de copiar: se guarda por valor en la celda.
+template <typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t minCapacity) : head(0), tail(0) {
+        size_t capacity = 2;
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        mask = capacity - 1;
+        cells.reset(new Cell[capacity]);
+        for (size_t i = 0; i < capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // No bloquea: devuelve false si el anillo está lleno
+    bool tryPush(const T& item) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.item = item;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Solo desde el hilo consumidor
+    bool tryPop(T& item) {
+        size_t position = head.load(std::memory_order_relaxed);
+        Cell& cell = cells[position & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+        item = cell.item;
+        cell.sequence.store(position + mask + 1, std::memory_order_release);
+        head.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Solo desde el hilo consumidor: hay un elemento listo para tryPop
+    bool readable() const {
+        size_t position = head.load(std::memory_order_relaxed);
+        return cells[position & mask].sequence.load(std::memory_order_acquire) == position + 1;
+    }
+
+    // Aproximado: para estado y métricas
+    size_t size() const {
+        size_t produced = tail.load(std::memory_order_relaxed);
+        size_t consumed = head.load(std::memory_order_relaxed);
+        return produced > consumed ? produced - consumed : 0;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T item{};
+    };
+
+    size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    // head solo lo escribe el consumidor; otros hilos lo leen como estimación
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+#endif // MPSC_QUEUE_H
@@ -0,0 +1,393 @@
+#include "payment_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <iostream>
+#include <unordered_map>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace {
+
+const char LOG_MAGIC[] = "TXSCHED1";
+const size_t LOG_MAGIC_LENGTH = 8;
+const char ADDED = 'A';    // 'A' secuencia(8) vencimiento_ms(8) largo(4) transacción serializada
+const char RELEASED = 'D'; // 'D' secuencia(8)
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool take(const char*& cursor, const char* end, T& value) {
+    if (static_cast<size_t>(end - cursor) < sizeof(value)) {
+        return false;
+    }
+    memcpy(&value, cursor, sizeof(value));
+    cursor += sizeof(value);
+    return true;
+}
+
+std::string addedRecord(uint64_t sequence, int64_t dueMillis, const std::string& text) {
+    std::string out;
+    out.reserve(1 + 8 + 8 + 4 + text.size());
+    out.push_back(ADDED);
+    put(out, sequence);
+    put(out, dueMillis);
+    put(out, static_cast<uint32_t>(text.size()));
+    out.append(text);
+    return out;
+}
+
+bool writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+PaymentScheduler::PaymentScheduler(const std::string& path, size_t batchSize, bool syncWrites)
+    : path(path), batchSize(batchSize ? batchSize : 1), syncWrites(syncWrites), fd(-1),
+      current(wallSecond()), running(false) {}
+
+PaymentScheduler::~PaymentScheduler() {
+    stop();
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+int64_t PaymentScheduler::wallSecond() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool PaymentScheduler::recover(std::string& error) {
+    if (!persistent()) {
+        return true;
+    }
+
+    std::string content;
+    int input = open(path.c_str(), O_RDONLY);
+    if (input >= 0) {
+        char buffer[1 << 16];
+        ssize_t n;
+        while ((n = read(input, buffer, sizeof(buffer))) > 0) {
+            content.append(buffer, static_cast<size_t>(n));
+        }
+        close(input);
+        if (n < 0) {
+            error = "no se pudo leer " + path + ": " + strerror(errno);
+            return false;
+        }
+    } else if (errno != ENOENT) {
+        error = "no se pudo abrir " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    // Asientos pendientes en orden de secuencia; los liberados se descartan
+    struct Pending {
+        int64_t dueMillis;
+        std::string text;
+    };
+    std::unordered_map<uint64_t, Pending> pending;
+    std::vector<uint64_t> order;
+    size_t truncated = 0;
+    if (!content.empty()) {
+        if (content.size() < LOG_MAGIC_LENGTH || memcmp(content.data(), LOG_MAGIC, LOG_MAGIC_LENGTH) != 0) {
+            error = path + " no es un registro de transacciones programadas";
+            return false;
+        }
+        const char* cursor = content.data() + LOG_MAGIC_LENGTH;
+        const char* end = content.data() + content.size();
+        while (cursor < end) {
+            char kind = *cursor++;
+            uint64_t sequence;
+            if (!take(cursor, end, sequence)) {
+                truncated++;
+                break;
+            }
+            if (kind == RELEASED) {
+                pending.erase(sequence);
+                continue;
+            }
+            int64_t dueMillis;
+            uint32_t length;
+            if (kind != ADDED || !take(cursor, end, dueMillis) || !take(cursor, end, length) ||
+                static_cast<size_t>(end - cursor) < length) {
+                truncated++; // asiento a medio escribir al caer el proceso
+                break;
+            }
+            pending[sequence] = Pending{dueMillis, std::string(cursor, length)};
+            order.push_back(sequence);
+            cursor += length;
+            if (sequence >= nextSequence) {
+                nextSequence = sequence + 1;
+            }
+        }
+    }
+
+    // Compactación: el registro nuevo solo tiene las pendientes
+    std::vector<std::string> records;
+    records.reserve(pending.size());
+    std::lock_guard<std::mutex> lock(mutex);
+    current = wallSecond();
+    size_t rejected = 0;
+    for (uint64_t sequence : order) {
+        auto it = pending.find(sequence);
+        if (it == pending.end()) {
+            continue;
+        }
+        Transaction t;
+        if (!Transaction::deserialize(it->second.text, t)) {
+            rejected++;
+            pending.erase(it);
+            continue;
+        }
+        records.push_back(addedRecord(sequence, it->second.dueMillis, it->second.text));
+        insert(Entry{TransactionRecord::pack(t, strings), (it->second.dueMillis + 999) / 1000, sequence});
+        pending.erase(it);
+    }
+    if (!rewrite(records, error)) {
+        return false;
+    }
+
+    pendingCount = records.size();
+    recoveredTotal = records.size();
+    if (!records.empty() || truncated > 0 || rejected > 0) {
+        std::cout << "[INFO] Transacciones programadas recuperadas de " << path << ": " << records.size()
+                  << " pendientes (" << overdue.size() << " ya vencidas), " << truncated
+                  << " asientos truncados, " << rejected << " ilegibles" << std::endl;
+    }
+    return true;
+}
+
+// Escribe el registro compactado en un archivo temporal y lo reemplaza de una vez
+bool PaymentScheduler::rewrite(const std::vector<std::string>& records, std::string& error) {
+    std::string temporary = path + ".tmp";
+    int output = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (output < 0) {
+        error = "no se pudo crear " + temporary + ": " + strerror(errno);
+        return false;
+    }
+    std::string buffer(LOG_MAGIC, LOG_MAGIC_LENGTH);
+    bool ok = true;
+    for (const std::string& record : records) {
+        buffer.append(record);
+        if (buffer.size() >= (1 << 20)) {
+            ok = ok && writeAll(output, buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    ok = ok && writeAll(output, buffer.data(), buffer.size()) && fsync(output) == 0;
+    close(output);
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+        error = "no se pudo escribir " + path + ": " + strerror(errno);
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    fd = open(path.c_str(), O_WRONLY | O_APPEND);
+    if (fd < 0) {
+        error = "no se pudo abrir " + path + ": " + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool PaymentScheduler::append(const std::string& bytes, std::string& error) {
+    if (!persistent()) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (fd < 0) {
+        error = "registro de programadas cerrado";
+        return false;
+    }
+    if (!writeAll(fd, bytes.data(), bytes.size()) || (syncWrites && fdatasync(fd) != 0)) {
+        error = std::string("no se pudo escribir el registro de programadas: ") + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void PaymentScheduler::start(ReleaseHandler releaseHandler) {
+    if (running.exchange(true)) {
+        return;
+    }
+    handler = std::move(releaseHandler);
+    thread = std::thread(&PaymentScheduler::run, this);
+}
+
+void PaymentScheduler::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        wakeup.notify_all();
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+    // Sin fdatasync por asiento, los últimos quedan en disco al detenerse. El registro
+    // se cierra: otro proceso puede tomarlo (traspaso del socket de escucha).
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (fd >= 0) {
+        if (!syncWrites) {
+            fdatasync(fd);
+        }
+        close(fd);
+        fd = -1;
+    }
+}
+
+bool PaymentScheduler::schedule(const Transaction& t, int64_t dueMillis, std::string& error) {
+    if (!running) {
+        error = "planificador detenido";
+        return false;
+    }
+    int64_t dueSecond = (dueMillis + 999) / 1000; // nunca antes de la hora pedida
+    // Un casillero de margen: `current` puede ir un segundo detrás del reloj
+    int64_t horizon = wallSecond() + (int64_t(1) << (SLOT_BITS * LEVELS)) - static_cast<int64_t>(SLOTS);
+    if (dueSecond > horizon) {
+        error = "fecha de ejecución fuera de rango";
+        return false;
+    }
+
+    uint64_t sequence = nextSequence.fetch_add(1);
+    if (!append(addedRecord(sequence, dueMillis, t.serialize()), error)) {
+        return false;
+    }
+    Entry entry{TransactionRecord::pack(t, strings), dueSecond, sequence};
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        insert(std::move(entry));
+    }
+    pendingCount++;
+    scheduledTotal++;
+    return true;
+}
+
+void PaymentScheduler::insert(Entry&& entry) {
+    if (entry.dueSecond <= current) {
+        overdue.push_back(std::move(entry));
+        return;
+    }
+    uint64_t delta = static_cast<uint64_t>(entry.dueSecond - current);
+    size_t level = 0;
+    while (level + 1 < LEVELS && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    size_t slot = static_cast<size_t>(entry.dueSecond >> (SLOT_BITS * level)) & (SLOTS - 1);
+    wheel[level][slot].push_back(std::move(entry));
+}
+
+// Avanza segundo a segundo hasta `second`. En cada segundo que completa una vuelta
+// de los niveles inferiores, el casillero del nivel superior se redistribuye (de
+// mayor a menor nivel, así lo que baja varios niveles llega a tiempo) y después se
+// vacía el casillero del nivel 0.
+void PaymentScheduler::advance(int64_t second, std::vector<Entry>& due) {
+    for (Entry& entry : overdue) {
+        due.push_back(std::move(entry));
+    }
+    std::vector<Entry>().swap(overdue);
+
+    while (current < second) {
+        current++;
+        for (size_t level = LEVELS - 1; level >= 1; level--) {
+            uint64_t span = uint64_t(1) << (SLOT_BITS * level);
+            if (static_cast<uint64_t>(current) % span != 0) {
+                continue;
+            }
+            std::vector<Entry> moving;
+            moving.swap(wheel[level][static_cast<size_t>(current >> (SLOT_BITS * level)) & (SLOTS - 1)]);
+            for (Entry& entry : moving) {
+                insert(std::move(entry));
+            }
+        }
+        std::vector<Entry>& slot = wheel[0][static_cast<size_t>(current) & (SLOTS - 1)];
+        for (Entry& entry : slot) {
+            due.push_back(std::move(entry));
+        }
+        std::vector<Entry>().swap(slot); // un pico de fin de mes no retiene memoria
+        for (Entry& entry : overdue) {
+            due.push_back(std::move(entry)); // bajaron al segundo actual al redistribuir
+        }
+        overdue.clear();
+    }
+}
+
+void PaymentScheduler::run() {
+    std::vector<Entry> due;
+    while (running.load()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto nextSecond = std::chrono::system_clock::time_point(std::chrono::seconds(current + 1));
+            wakeup.wait_until(lock, nextSecond, [&] {
+                return !running.load() || std::chrono::system_clock::now() >= nextSecond;
+            });
+            if (!running.load()) {
+                break;
+            }
+            advance(wallSecond(), due);
+        }
+        if (!due.empty()) {
+            release(due);
+            due.clear();
+        }
+    }
+}
+
+void PaymentScheduler::release(std::vector<Entry>& due) {
+    if (due.size() > largestRelease) {
+        largestRelease = due.size();
+    }
+    std::vector<Transaction> batch;
+    batch.reserve(std::min(batchSize, due.size()));
+    std::string released;
+    for (size_t start = 0; start < due.size(); start += batchSize) {
+        size_t end = std::min(due.size(), start + batchSize);
+        batch.clear();
+        released.clear();
+        for (size_t i = start; i < end; i++) {
+            batch.push_back(due[i].record.unpack(strings));
+            released.push_back(RELEASED);
+            put(released, due[i].sequence);
+        }
+
+        // Se marca antes de ejecutar: un reinicio no vuelve a ejecutar este lote
+        std::string error;
+        if (!append(released, error)) {
+            std::cerr << "[ERROR] " << error << std::endl;
+        }
+        handler(batch);
+        pendingCount -= batch.size();
+        releasedTotal += batch.size();
+    }
+}
+
+std::string PaymentScheduler::describe() const {
+    std::stringstream ss;
+    ss << "Pendientes: " << pendingCount.load() << "\n";
+    ss << "Programadas: " << scheduledTotal.load() << " (recuperadas al arrancar: " << recoveredTotal.load() << ")\n";
+    ss << "Liberadas: " << releasedTotal.load() << " (máximo en un segundo: " << largestRelease.load()
+       << ", lotes de " << batchSize << ")\n";
+    ss << "Registro: " << (persistent() ? path + (syncWrites ? " (fdatasync por asiento)" : "")
+                                        : std::string("solo en memoria (SCHEDULE_FILE no definido)")) << "\n";
+    return ss.str();
+}
@@ -0,0 +1,106 @@
+#ifndef PAYMENT_SCHEDULER_H
+#define PAYMENT_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include "crypto_utils.h"
+#include "transaction_record.h"
+
+// Transacciones programadas para una fecha futura. Un único hilo avanza una rueda de
+// temporizadores jerárquica de segundo en segundo y entrega las vencidas en lotes al
+// camino normal de ejecución; no hay un hilo ni un temporizador del sistema por
+// transacción.
+//
+// La rueda tiene LEVELS niveles de 64 casilleros: el nivel 0 cubre los próximos 64
+// segundos, el 1 los próximos 64^2, etc. (5 niveles, unos 34 años). Cada casillero
+// guarda las transacciones en forma compacta (TransactionRecord), que reproduce
+// exactamente la transacción aceptada, monto incluido. Programar es O(1);
+// cuando un nivel da la vuelta, el casillero correspondiente del nivel superior se
+// redistribuye en los inferiores. Un segundo con millones de vencimientos (fin de
+// mes) se libera en lotes de `batchSize`.
+//
+// Persistencia (opcional): registro de solo anexar con un asiento por transacción
+// programada y otro por transacción liberada. Al arrancar se reproduce, se compacta
+// con solo las pendientes y las ya vencidas se liberan en el primer segundo. Una
+// transacción se marca como liberada antes de ejecutarse: ante una caída entre ambos
+// pasos se pierde a lo sumo ese lote, nunca se ejecuta dos veces.
+class PaymentScheduler {
+public:
+    // Recibe las transacciones vencidas desde el hilo del planificador
+    using ReleaseHandler = std::function<void(std::vector<Transaction>& due)>;
+
+    static const size_t LEVELS = 5;
+    static const size_t SLOT_BITS = 6;
+    static const size_t SLOTS = 1 << SLOT_BITS;
+
+    // path vacío = solo en memoria; syncWrites hace fdatasync de cada asiento
+    PaymentScheduler(const std::string& path, size_t batchSize, bool syncWrites);
+    ~PaymentScheduler();
+
+    PaymentScheduler(const PaymentScheduler&) = delete;
+    PaymentScheduler& operator=(const PaymentScheduler&) = delete;
+
+    // Reproduce y compacta el registro en disco; antes de start()
+    bool recover(std::string& error);
+    void start(ReleaseHandler handler);
+    // Detiene el hilo y cierra el registro, donde quedan las pendientes; después
+    // schedule() falla
+    void stop();
+
+    // Programa la transacción para `dueMillis` (ms desde epoch). Falla si la fecha
+    // excede el alcance de la rueda o no se pudo escribir el registro.
+    bool schedule(const Transaction& t, int64_t dueMillis, std::string& error);
+
+    bool persistent() const { return !path.empty(); }
+    uint64_t pending() const { return pendingCount.load(); }
+    std::string describe() const;
+
+private:
+    struct Entry {
+        TransactionRecord record;
+        int64_t dueSecond;
+        uint64_t sequence;
+    };
+
+    static int64_t wallSecond();
+    // Requieren `mutex`
+    void insert(Entry&& entry);
+    void advance(int64_t second, std::vector<Entry>& due);
+
+    void run();
+    void release(std::vector<Entry>& due);
+    bool append(const std::string& bytes, std::string& error);
+    bool rewrite(const std::vector<std::string>& records, std::string& error);
+
+    std::string path;
+    size_t batchSize;
+    bool syncWrites;
+    int fd;
+    std::mutex logMutex;
+
+    StringPool strings;
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    std::vector<Entry> wheel[LEVELS][SLOTS];
+    std::vector<Entry> overdue; // vencidas al programarse; salen en el próximo segundo
+    int64_t current;            // último segundo procesado
+
+    ReleaseHandler handler;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    std::atomic<uint64_t> nextSequence{1};
+    std::atomic<uint64_t> pendingCount{0};
+    std::atomic<uint64_t> scheduledTotal{0};
+    std::atomic<uint64_t> releasedTotal{0};
+    std::atomic<uint64_t> recoveredTotal{0};
+    std::atomic<uint64_t> largestRelease{0};
+};
+
+#endif // PAYMENT_SCHEDULER_H
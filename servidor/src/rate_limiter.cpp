@@ -0,0 +1,76 @@
+#include "rate_limiter.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+RateLimiter::RateLimiter(double ratePerSecond, double burst)
+    : ratePerSecond(ratePerSecond), burst(std::max(1.0, burst)) {}
+
+int64_t RateLimiter::nowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RateLimiter::configure(double newRate, double newBurst) {
+    ratePerSecond.store(newRate, std::memory_order_relaxed);
+    burst.store(std::max(1.0, newBurst), std::memory_order_relaxed);
+}
+
+bool RateLimiter::allow(const std::string& key) {
+    double rate = ratePerSecond.load(std::memory_order_relaxed);
+    if (rate <= 0) {
+        return true;
+    }
+    double capacity = burst.load(std::memory_order_relaxed);
+    int64_t now = nowNanos();
+
+    Shard& shard = shards[std::hash<std::string>{}(key) % SHARDS];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.buckets.find(key);
+    if (it == shard.buckets.end()) {
+        if (shard.buckets.size() >= MAX_BUCKETS_PER_SHARD) {
+            evictOldest(shard);
+        }
+        it = shard.buckets.emplace(key, Bucket{capacity, now, {}}).first;
+        shard.recent.push_front(&it->first);
+        it->second.recent = shard.recent.begin();
+    } else {
+        shard.recent.splice(shard.recent.begin(), shard.recent, it->second.recent);
+    }
+
+    Bucket& bucket = it->second;
+    double elapsed = static_cast<double>(now - bucket.lastRefillNanos) / 1e9;
+    bucket.tokens = std::min(capacity, bucket.tokens + elapsed * rate);
+    bucket.lastRefillNanos = now;
+
+    if (bucket.tokens < 1.0) {
+        rejectedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+void RateLimiter::refund(const std::string& key) {
+    if (ratePerSecond.load(std::memory_order_relaxed) <= 0) {
+        return;
+    }
+    double capacity = burst.load(std::memory_order_relaxed);
+
+    Shard& shard = shards[std::hash<std::string>{}(key) % SHARDS];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // Si el bucket ya se descartó, uno nuevo empieza lleno: no hay nada que devolver
+    auto it = shard.buckets.find(key);
+    if (it != shard.buckets.end()) {
+        it->second.tokens = std::min(capacity, it->second.tokens + 1.0);
+    }
+}
+
+// Olvidar una clave equivale a darle un bucket lleno la próxima vez; la usada hace
+// más tiempo es la que más probablemente ya se recargó
+void RateLimiter::evictOldest(Shard& shard) {
+    auto it = shard.buckets.find(*shard.recent.back());
+    shard.recent.pop_back();
+    shard.buckets.erase(it);
+}
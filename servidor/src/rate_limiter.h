@@ -0,0 +1,60 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <string>
+#include <unordered_map>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+// Limitador por clave (IP, cuenta) con token buckets de recarga perezosa: no hay
+// hilo de recarga, cada bucket se repone al consultarlo según el tiempo transcurrido.
+// La tabla se divide en fragmentos con su propio lock para que claves distintas
+// casi nunca compitan, y los límites se pueden cambiar en caliente. Cada fragmento
+// guarda a lo sumo MAX_BUCKETS_PER_SHARD claves: al llegar una nueva con el
+// fragmento lleno se descarta la usada hace más tiempo (LRU, O(1)).
+class RateLimiter {
+public:
+    static const size_t SHARDS = 32;
+
+    // ratePerSecond <= 0 desactiva el limitador
+    RateLimiter(double ratePerSecond, double burst);
+
+    bool allow(const std::string& key);
+    // Devuelve el permiso de un allow() aceptado cuya operación no se llegó a hacer
+    // (p. ej. un lote rechazado por el límite de otra de sus cuentas)
+    void refund(const std::string& key);
+    void configure(double ratePerSecond, double burst);
+
+    double rate() const { return ratePerSecond.load(std::memory_order_relaxed); }
+    double burstSize() const { return burst.load(std::memory_order_relaxed); }
+    uint64_t rejected() const { return rejectedCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Bucket {
+        double tokens;
+        int64_t lastRefillNanos;
+        std::list<const std::string*>::iterator recent; // posición en Shard::recent
+    };
+
+    // Alineado a línea de caché para evitar false sharing entre fragmentos
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Bucket> buckets;
+        // Claves de `buckets` de la más a la menos reciente (los nodos del mapa no se mueven)
+        std::list<const std::string*> recent;
+    };
+
+    static const size_t MAX_BUCKETS_PER_SHARD = 4096;
+
+    static int64_t nowNanos();
+    static void evictOldest(Shard& shard);
+
+    std::atomic<double> ratePerSecond;
+    std::atomic<double> burst;
+    std::atomic<uint64_t> rejectedCount{0};
+    Shard shards[SHARDS];
+};
+
+#endif // RATE_LIMITER_H
@@ -0,0 +1,55 @@
+#ifndef RESPONSE_WRITER_H
+#define RESPONSE_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+#include <cstddef>
+
+// Escribe respuestas directamente en un búfer reutilizable de la conexión.
+// Los literales se copian con su longitud conocida en compilación y los números
+// se formatean con std::to_chars (sin locale ni stringstream), así que una vez
+// que el búfer alcanzó su capacidad de trabajo no se hacen más reservas de memoria.
+class ResponseWriter {
+public:
+    explicit ResponseWriter(std::string& buffer) : buffer(buffer) {}
+
+    template <size_t N>
+    ResponseWriter& operator<<(const char (&literal)[N]) {
+        buffer.append(literal, N - 1);
+        return *this;
+    }
+
+    ResponseWriter& operator<<(std::string_view text) {
+        buffer.append(text.data(), text.size());
+        return *this;
+    }
+
+    ResponseWriter& operator<<(char c) {
+        buffer.push_back(c);
+        return *this;
+    }
+
+    // Mismo formato que std::ostream por defecto (%g con 6 dígitos significativos)
+    ResponseWriter& operator<<(double value) {
+        char digits[32];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, 6);
+        buffer.append(digits, result.ptr - digits);
+        return *this;
+    }
+
+    ResponseWriter& operator<<(uint64_t value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, result.ptr - digits);
+        return *this;
+    }
+
+    size_t size() const { return buffer.size(); }
+
+private:
+    std::string& buffer;
+};
+
+#endif // RESPONSE_WRITER_H
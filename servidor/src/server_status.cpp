@@ -0,0 +1,82 @@
+#include "server_status.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+ThroughputMeter::ThroughputMeter() {
+    for (auto& slot : slots) {
+        slot.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t ThroughputMeter::currentSecond() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ThroughputMeter::record() {
+    uint64_t second = currentSecond();
+    std::atomic<uint64_t>& slot = slots[second % WINDOW_SECONDS];
+    uint64_t current = slot.load(std::memory_order_relaxed);
+    uint64_t updated;
+    do {
+        // Si la ranura pertenece a un segundo anterior, se reinicia su conteo
+        updated = (current >> COUNT_BITS) == second
+            ? current + 1
+            : (second << COUNT_BITS) | 1;
+    } while (!slot.compare_exchange_weak(current, updated, std::memory_order_relaxed));
+}
+
+double ThroughputMeter::ratePerSecond(int seconds) const {
+    seconds = std::max(1, std::min(seconds, WINDOW_SECONDS - 1));
+    uint64_t now = currentSecond();
+    uint64_t total = 0;
+    // El segundo en curso está incompleto y se excluye
+    for (int i = 1; i <= seconds; i++) {
+        uint64_t second = now - i;
+        uint64_t value = slots[second % WINDOW_SECONDS].load(std::memory_order_relaxed);
+        if ((value >> COUNT_BITS) == second) {
+            total += value & COUNT_MASK;
+        }
+    }
+    return static_cast<double>(total) / seconds;
+}
+
+void HotAccountSampler::touch(const std::string& account) {
+    // Desfase inicial distinto por hilo para que los hilos de vida corta también muestreen
+    static std::atomic<unsigned int> nextOffset{0};
+    thread_local unsigned int counter = nextOffset.fetch_add(1, std::memory_order_relaxed);
+    if (account.empty() || ++counter % SAMPLE_RATE != 0) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+
+    samples[account]++;
+    if (samples.size() > MAX_TRACKED) {
+        // Decaimiento: se reducen los conteos a la mitad y se olvidan las cuentas frías
+        for (auto it = samples.begin(); it != samples.end();) {
+            it->second /= 2;
+            it = it->second == 0 ? samples.erase(it) : std::next(it);
+        }
+    }
+}
+
+std::vector<std::pair<std::string, uint64_t>> HotAccountSampler::top(size_t count) {
+    std::vector<std::pair<std::string, uint64_t>> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        result.assign(samples.begin(), samples.end());
+    }
+
+    count = std::min(count, result.size());
+    std::partial_sort(result.begin(), result.begin() + count, result.end(),
+        [](const std::pair<std::string, uint64_t>& a, const std::pair<std::string, uint64_t>& b) {
+            return a.second > b.second;
+        });
+    result.resize(count);
+    return result;
+}
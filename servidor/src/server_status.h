@@ -0,0 +1,50 @@
+#ifndef SERVER_STATUS_H
+#define SERVER_STATUS_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
+
+// Throughput por segundo en una ventana circular de WINDOW_SECONDS segundos.
+// Cada ranura empaqueta (segundo, conteo) en un único atómico, así que registrar
+// un evento es un CAS sin locks.
+class ThroughputMeter {
+public:
+    static const int WINDOW_SECONDS = 60;
+
+    ThroughputMeter();
+
+    void record();
+    // Eventos por segundo promediados sobre los últimos `seconds` segundos completos
+    double ratePerSecond(int seconds) const;
+
+private:
+    static const int COUNT_BITS = 24;
+    static const uint64_t COUNT_MASK = (1ULL << COUNT_BITS) - 1;
+
+    static uint64_t currentSecond();
+
+    std::atomic<uint64_t> slots[WINDOW_SECONDS];
+};
+
+// Muestreo de cuentas más accedidas. Solo 1 de cada SAMPLE_RATE accesos llega a la
+// tabla y se usa try_lock: si el lock está ocupado la muestra se descarta en lugar
+// de bloquear el procesamiento de transacciones.
+class HotAccountSampler {
+public:
+    static const int SAMPLE_RATE = 16;
+    static const size_t MAX_TRACKED = 1024;
+
+    void touch(const std::string& account);
+    std::vector<std::pair<std::string, uint64_t>> top(size_t count);
+
+private:
+    std::mutex mutex;
+    std::unordered_map<std::string, uint64_t> samples;
+};
+
+#endif // SERVER_STATUS_H
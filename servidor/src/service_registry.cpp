@@ -0,0 +1,221 @@
+#include "service_registry.h"
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <iostream>
+#include <cstring>
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+bool validCode(std::string_view code) {
+    if (code.empty() || code.size() > ServiceCatalog::MAX_CODE_LENGTH) {
+        return false;
+    }
+    for (char c : code) {
+        // El código viaja en mensajes separados por '|'
+        if (c <= ' ' || c == '|' || c == ',') {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// FNV-1a con una mezcla final: los códigos comparten prefijos largos ("EAAB001",
+// "EAAB002"...) y el sondeo lineal usa los bits bajos
+uint64_t ServiceCatalog::hash(std::string_view code) {
+    uint64_t h = 1469598103934665603ULL;
+    for (char c : code) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+ServiceCatalog::ServiceCatalog(const std::vector<std::string_view>& codes) {
+    size_t capacity = 16;
+    while (capacity < codes.size() * 2) {
+        capacity <<= 1;
+    }
+    slots.assign(capacity, Slot{});
+    mask = capacity - 1;
+
+    for (std::string_view code : codes) {
+        if (code.empty() || code.size() > MAX_CODE_LENGTH) {
+            continue;
+        }
+        uint64_t h = hash(code);
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            Slot& slot = slots[i];
+            if (slot.length == 0) {
+                slot.hash = h;
+                memcpy(slot.code, code.data(), code.size());
+                slot.length = static_cast<uint8_t>(code.size());
+                count++;
+                break;
+            }
+            if (slot.hash == h && slot.length == code.size() && memcmp(slot.code, code.data(), code.size()) == 0) {
+                break;
+            }
+        }
+    }
+}
+
+bool ServiceCatalog::contains(std::string_view code) const {
+    if (code.empty() || code.size() > MAX_CODE_LENGTH) {
+        return false;
+    }
+    uint64_t h = hash(code);
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        const Slot& slot = slots[i];
+        if (slot.length == 0) {
+            return false;
+        }
+        if (slot.hash == h && slot.length == code.size() && memcmp(slot.code, code.data(), code.size()) == 0) {
+            return true;
+        }
+    }
+}
+
+ServiceRegistry::ServiceRegistry(const std::string& path) : path(path) {}
+
+ServiceRegistry::~ServiceRegistry() {
+    if (reloader.joinable()) {
+        reloader.join();
+    }
+}
+
+bool ServiceRegistry::load(std::string& error) {
+    return build(error);
+}
+
+bool ServiceRegistry::build(std::string& error) {
+    auto started = std::chrono::steady_clock::now();
+
+    std::ifstream file(path);
+    if (!file) {
+        error = "no se pudo abrir el catálogo de servicios " + path;
+        return false;
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+    std::string text = content.str();
+
+    LoadReport report;
+    std::vector<std::string_view> codes;
+    codes.reserve(text.size() / 8 + 1);
+    std::string_view remaining(text);
+    while (!remaining.empty()) {
+        size_t newline = remaining.find('\n');
+        std::string_view line = trim(remaining.substr(0, newline));
+        remaining = newline == std::string_view::npos ? std::string_view() : remaining.substr(newline + 1);
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        std::string_view code = trim(line.substr(0, line.find(',')));
+        if (!validCode(code)) {
+            report.rejected++;
+            continue;
+        }
+        codes.push_back(code);
+    }
+
+    auto catalog = std::make_shared<const ServiceCatalog>(codes);
+    report.codes = catalog->size();
+    report.duplicates = codes.size() - catalog->size();
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (catalog->size() == 0) {
+        error = "el catálogo de servicios " + path + " no contiene códigos válidos";
+        return false;
+    }
+
+    std::atomic_store(&current, std::shared_ptr<const ServiceCatalog>(catalog));
+    version.fetch_add(1, std::memory_order_release);
+
+    std::lock_guard<std::mutex> lock(reportMutex);
+    lastReport = report;
+    lastError.clear();
+    return true;
+}
+
+bool ServiceRegistry::reloadAsync() {
+    if (!enabled() || reloading.exchange(true)) {
+        return false;
+    }
+    if (reloader.joinable()) {
+        reloader.join(); // la recarga anterior ya terminó
+    }
+    reloader = std::thread([this]() {
+        std::string error;
+        if (build(error)) {
+            reloads++;
+            std::cout << "[SUCCESS] Catálogo de servicios recargado: " << describe() << std::endl;
+        } else {
+            failedReloads++;
+            std::cerr << "[ERROR] Recarga del catálogo de servicios fallida, se mantiene el anterior: "
+                      << error << std::endl;
+            std::lock_guard<std::mutex> lock(reportMutex);
+            lastError = error;
+        }
+        reloading = false;
+    });
+    return true;
+}
+
+bool ServiceRegistry::contains(std::string_view code) const {
+    if (!enabled()) {
+        return true;
+    }
+
+    // Cada hilo conserva su referencia al catálogo y solo la renueva cuando cambia la
+    // versión, así la consulta no toca el contador compartido del shared_ptr. Un
+    // catálogo reemplazado vive hasta la siguiente consulta de cada hilo que lo usaba.
+    struct Cache {
+        const ServiceRegistry* owner = nullptr;
+        uint64_t version = 0;
+        std::shared_ptr<const ServiceCatalog> catalog;
+    };
+    thread_local Cache cache;
+
+    uint64_t published = version.load(std::memory_order_acquire);
+    if (cache.owner != this || cache.version != published) {
+        cache.catalog = std::atomic_load(&current);
+        cache.owner = this;
+        cache.version = published;
+    }
+    return cache.catalog && cache.catalog->contains(code);
+}
+
+std::string ServiceRegistry::describe() const {
+    if (!enabled()) {
+        return "desactivado (SERVICES_FILE no definido): se acepta cualquier código";
+    }
+    std::shared_ptr<const ServiceCatalog> catalog = std::atomic_load(&current);
+    std::lock_guard<std::mutex> lock(reportMutex);
+    std::stringstream ss;
+    ss.setf(std::ios::fixed);
+    ss.precision(1);
+    ss << (catalog ? catalog->size() : 0) << " códigos de " << path << " (" << (catalog ? catalog->capacity() : 0)
+       << " ranuras, " << (catalog ? catalog->memoryBytes() : 0) / 1024.0 << " KB) en "
+       << lastReport.seconds * 1000.0 << " ms; " << lastReport.rejected << " rechazados, "
+       << lastReport.duplicates << " duplicados; versión " << version.load() << ", "
+       << reloads.load() << " recargas";
+    if (failedReloads > 0) {
+        ss << ", " << failedReloads.load() << " fallidas (última: " << lastError << ")";
+    }
+    return ss.str();
+}
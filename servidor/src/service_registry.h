@@ -0,0 +1,90 @@
+#ifndef SERVICE_REGISTRY_H
+#define SERVICE_REGISTRY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+
+// Catálogo inmutable de códigos de servicio (facturadores). Tabla de direccionamiento
+// abierto con sondeo lineal, tamaño potencia de dos y carga de a lo sumo 50%: cada
+// ranura guarda el hash y el código en línea (32 bytes, dos por línea de caché), así
+// que una consulta es un hash y en general una sola línea leída, sin seguir punteros.
+class ServiceCatalog {
+public:
+    static const size_t MAX_CODE_LENGTH = 22;
+
+    // Los códigos repetidos se guardan una vez; los vacíos o largos se ignoran
+    explicit ServiceCatalog(const std::vector<std::string_view>& codes);
+
+    bool contains(std::string_view code) const;
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+    size_t memoryBytes() const { return slots.size() * sizeof(Slot); }
+
+    static uint64_t hash(std::string_view code);
+
+private:
+    struct Slot {
+        uint64_t hash;
+        char code[MAX_CODE_LENGTH];
+        uint8_t length; // 0 = ranura libre
+        uint8_t padding;
+    };
+    static_assert(sizeof(Slot) == 32, "Slot debe ocupar media línea de caché");
+
+    std::vector<Slot> slots;
+    size_t mask = 0;
+    size_t count = 0;
+};
+
+// Registro de servicios habilitados para PAYMENT, cargado de SERVICES_FILE (un código
+// por línea, opcionalmente "codigo,nombre"; '#' comenta). Una recarga arma el catálogo
+// nuevo en un hilo propio y lo publica de una vez: las consultas en curso terminan
+// sobre el catálogo anterior, que se libera cuando el último hilo deja de usarlo.
+class ServiceRegistry {
+public:
+    // Con path vacío el registro está desactivado y acepta cualquier código
+    explicit ServiceRegistry(const std::string& path);
+    ~ServiceRegistry();
+
+    bool enabled() const { return !path.empty(); }
+
+    // Carga síncrona, para el arranque
+    bool load(std::string& error);
+    // Recarga en segundo plano; false si ya hay una en curso
+    bool reloadAsync();
+
+    bool contains(std::string_view code) const;
+
+    std::string describe() const;
+
+private:
+    struct LoadReport {
+        size_t codes = 0;
+        size_t rejected = 0;   // líneas con códigos vacíos, largos o con caracteres inválidos
+        size_t duplicates = 0;
+        double seconds = 0.0;
+    };
+
+    bool build(std::string& error);
+
+    std::string path;
+    std::shared_ptr<const ServiceCatalog> current; // se lee y publica con atomic_load/atomic_store
+    // Se incrementa después de publicar; los hilos renuevan su referencia al verlo cambiar
+    std::atomic<uint64_t> version{0};
+    std::atomic<bool> reloading{false};
+    std::thread reloader;
+    std::atomic<uint64_t> reloads{0};
+    std::atomic<uint64_t> failedReloads{0};
+
+    mutable std::mutex reportMutex;
+    LoadReport lastReport;
+    std::string lastError;
+};
+
+#endif // SERVICE_REGISTRY_H
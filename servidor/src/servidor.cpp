@@ -5,28 +5,149 @@
 #include <thread>
 #include <vector>
 #include <map>
+#include <optional>
 #include <mutex>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
 #include <signal.h>
+#include <poll.h>
+#include <fcntl.h>
 #include "crypto_utils.h"
+#include "metrics.h"
+#include "http_endpoint.h"
+#include "server_status.h"
+#include "work_queue.h"
+#include "rate_limiter.h"
+#include "response_writer.h"
+#include "frame_io.h"
+#include "shard_executor.h"
+#include "account_record.h"
+#include "account_loader.h"
+#include "transaction_record.h"
+#include "transaction_policy.h"
+#include "service_registry.h"
+#include "velocity_counters.h"
+#include "payment_scheduler.h"
+#include "connection_reaper.h"
+#include "listener_handoff.h"
+
+// Mensaje recibido a la espera de un hilo trabajador. El mensaje y el búfer de
+// respuesta pertenecen a la conexión, que espera bloqueada hasta que se complete.
+struct WorkItem {
+    const std::string* message = nullptr;
+    std::string* response = nullptr;
+    SecureSession* session = nullptr; // sesión de la conexión (puede no estar establecida)
+    bool viaSession = false;          // el mensaje llegó cifrado con la clave de sesión
+    std::chrono::steady_clock::time_point enqueuedAt;
+    std::chrono::steady_clock::time_point deadline;
+    std::promise<void> done;
+};
 
 class TransactionServer {
 private:
-    int serverSocket;
+    int serverSocket = -1;
     int port;
     std::string secretKey;
     std::string aesKey;
-    std::map<std::string, double> accounts; // Simulación de cuentas
-    std::vector<Transaction> transactionHistory;
-    std::mutex accountsMutex;
+    AccountTable accounts; // Simulación de cuentas (o cargadas de ACCOUNTS_FILE)
+    // Historial en forma compacta; los campos de texto irregulares van a historyStrings
+    std::vector<TransactionRecord> transactionHistory;
+    StringPool historyStrings;
+    // Las cuentas solo se crean en el constructor, así que la estructura de la tabla
+    // es de solo lectura en ejecución; los saldos se protegen por fragmento (shard)
+    static const size_t ACCOUNT_SHARDS = 16;
+    std::mutex accountShardMutexes[ACCOUNT_SHARDS];
     std::mutex historyMutex;
-    bool running;
+    // Con LEDGER_PARTITIONS > 0 los saldos viven en el ledger por particiones (un
+    // escritor por partición) en lugar de en `accounts` bajo los locks de fragmento
+    std::unique_ptr<ShardExecutor> ledger;
+
+    // Cuentas divididas: con SPLIT_ACCOUNT_THRESHOLD > 0, una cuenta que recibe más
+    // créditos por segundo que el umbral reparte su saldo en franjas por núcleo
+    uint32_t splitThreshold;
+    size_t splitStripes;
+    std::atomic<uint64_t> splitAccounts{0};
+    // Límites de cantidad y suma de débitos por cuenta (VELOCITY_*); sin límites por defecto
+    VelocityLimits velocityLimits;
+    std::atomic<uint64_t> velocityRejections{0};
+    // Transacciones con fecha de ejecución futura (rueda de temporizadores, SCHEDULE_*)
+    std::unique_ptr<PaymentScheduler> scheduler;
+    // Códigos de servicio válidos para PAYMENT (SERVICES_FILE); se recarga sin detener el servidor
+    ServiceRegistry services;
+    std::atomic<bool> running;
+    std::string startupError;
+    std::unique_ptr<HttpEndpoint> metricsEndpoint;
+    std::unique_ptr<HttpEndpoint> adminEndpoint;
+
+    // Contadores para el puerto de administración; se leen sin tomar locks del ledger
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<uint64_t> activeConnections{0};
+    std::atomic<uint64_t> acceptedConnections{0};
+    std::atomic<uint64_t> processedTransactions{0};
+    std::atomic<uint64_t> historySize{0};
+    ThroughputMeter throughput;
+    HotAccountSampler hotAccounts;
+
+    // Control de admisión: conexiones máximas, cola acotada y plazo de espera en cola
+    size_t maxConnections;
+    std::chrono::milliseconds queueDeadline;
+    std::unique_ptr<BoundedQueue<WorkItem>> workQueue;
+    std::vector<std::thread> workers;
+    std::atomic<uint64_t> rejectedConnections{0};
+    std::atomic<uint64_t> shedRequests{0};
+    // Plazos de inactividad, recepción de mensaje y envío (IDLE/FRAME/WRITE_TIMEOUT_MS)
+    std::unique_ptr<ConnectionReaper> reaper;
+
+    // Detención ordenada: deja de aceptar, termina los mensajes en curso hasta
+    // DRAIN_TIMEOUT_MS y puede traspasar el socket de escucha (HANDOFF_SOCKET)
+    std::atomic<bool> draining{false};
+    std::chrono::milliseconds drainTimeout;
+    std::string handoffPath;
+    int controlSocket = -1;
+    bool handedOff = false;
+
+    // Etapa criptográfica por lotes: con la cola profunda un trabajador toma varios
+    // mensajes y los verifica y descifra seguidos antes de ejecutarlos
+    size_t cryptoBatchSize;
+    size_t cryptoBatchDepth;
+    std::atomic<uint64_t> cryptoBatches{0};
+    std::atomic<uint64_t> cryptoBatchedMessages{0};
+    std::atomic<uint64_t> sessionsEstablished{0};
+
+    // Límites de tasa por IP de origen (antes de descifrar) y por cuenta (antes del token)
+    RateLimiter ipLimiter;
+    RateLimiter accountLimiter;
+
+    static long envLong(const char* name, long defaultValue) {
+        const char* value = std::getenv(name);
+        return value ? std::atol(value) : defaultValue;
+    }
+
+    static double envDouble(const char* name, double defaultValue) {
+        const char* value = std::getenv(name);
+        return value ? std::atof(value) : defaultValue;
+    }
+
+    // Límite de transacciones por lote para acotar el tiempo con los locks tomados
+    static const size_t MAX_BATCH_ITEMS = 10000;
+    // Tamaño máximo de un mensaje sin terminador antes de cerrar la conexión
+    size_t maxFrameBytes;
 
 public:
-    TransactionServer(int port = 8080) : port(port), running(false) {
+    TransactionServer(int port = 8080)
+        : port(port), services(std::getenv("SERVICES_FILE") ? std::getenv("SERVICES_FILE") : ""), running(false), startTime(std::chrono::steady_clock::now()),
+          // Desactivados salvo que se configure una tasa: la ráfaga es la que se usa al activarlos
+          ipLimiter(envDouble("RATE_LIMIT_IP_RPS", 0), envDouble("RATE_LIMIT_IP_BURST", 100)),
+          accountLimiter(envDouble("RATE_LIMIT_ACCOUNT_RPS", 0), envDouble("RATE_LIMIT_ACCOUNT_BURST", 40)) {
         // Clave secreta compartida (obtener de variables de entorno si están disponibles)
         const char* envSecretKey = std::getenv("SECRET_KEY");
         const char* envAesKey = std::getenv("AES_KEY");
@@ -43,21 +164,160 @@ public:
             aesKey = "mi_clave_aes_256_bits_muy_segura"; // Exactamente 32 caracteres
         }
         
-        // Inicializar algunas cuentas de prueba
-        accounts["1234567890123456"] = 5000.0;
-        accounts["6543210987654321"] = 3000.0;
-        accounts["1111222233334444"] = 1500.0;
+        maxConnections = static_cast<size_t>(std::max(1L, envLong("MAX_CONNECTIONS", 256)));
+        queueDeadline = std::chrono::milliseconds(std::max(1L, envLong("QUEUE_DEADLINE_MS", 2000)));
+        workQueue.reset(new BoundedQueue<WorkItem>(
+            static_cast<size_t>(std::max(1L, envLong("WORK_QUEUE_CAPACITY", 1024)))));
+        cryptoBatchSize = static_cast<size_t>(std::max(1L, envLong("CRYPTO_BATCH_SIZE", 16)));
+        maxFrameBytes = static_cast<size_t>(std::max(1024L, envLong("MAX_FRAME_BYTES", 4 * 1024 * 1024)));
+        ConnectionReaper::Timeouts timeouts;
+        timeouts.idleMillis = static_cast<uint32_t>(std::max(0L, envLong("IDLE_TIMEOUT_MS", 60000)));
+        timeouts.frameMillis = static_cast<uint32_t>(std::max(0L, envLong("FRAME_TIMEOUT_MS", 10000)));
+        timeouts.writeMillis = static_cast<uint32_t>(std::max(0L, envLong("WRITE_TIMEOUT_MS", 10000)));
+        reaper.reset(new ConnectionReaper(timeouts));
+        drainTimeout = std::chrono::milliseconds(std::max(0L, envLong("DRAIN_TIMEOUT_MS", 8000)));
+        const char* envHandoff = std::getenv("HANDOFF_SOCKET");
+        handoffPath = envHandoff ? envHandoff : "";
+
+        const char* accountsFile = std::getenv("ACCOUNTS_FILE");
+        if (accountsFile) {
+            AccountLoader::Report report;
+            std::string error;
+            if (AccountLoader::load(accountsFile, static_cast<size_t>(std::max(0L, envLong("ACCOUNTS_LOAD_THREADS", 0))),
+                                    accounts, report, error)) {
+                std::cout << "[SUCCESS] Cargadas " << AccountLoader::describe(report) << std::endl;
+            } else {
+                startupError = "No se pudieron cargar las cuentas: " + error;
+            }
+        } else {
+            // Inicializar algunas cuentas de prueba
+            accounts["1234567890123456"].balance = 5000.0;
+            accounts["6543210987654321"].balance = 3000.0;
+            accounts["1111222233334444"].balance = 1500.0;
+        }
+
+        if (services.enabled()) {
+            std::string error;
+            if (services.load(error)) {
+                std::cout << "[SUCCESS] Catálogo de servicios: " << services.describe() << std::endl;
+            } else if (startupError.empty()) {
+                startupError = "No se pudo cargar el catálogo de servicios: " + error;
+            }
+        } else {
+            std::cout << "[WARNING] Catálogo de servicios " << services.describe() << std::endl;
+        }
+
+        const char* const velocityWindows[VelocityLimits::WINDOWS] = {"MINUTE", "HOUR", "DAY"};
+        for (size_t w = 0; w < VelocityLimits::WINDOWS; w++) {
+            std::string prefix = std::string("VELOCITY_") + velocityWindows[w];
+            velocityLimits.maxCount[w] = static_cast<uint32_t>(
+                std::min<long>(UINT16_MAX, std::max(0L, envLong((prefix + "_COUNT").c_str(), 0))));
+            velocityLimits.maxAmount[w] = std::max(0.0, envDouble((prefix + "_AMOUNT").c_str(), 0.0));
+        }
+        if (velocityLimits.enabled()) {
+            std::cout << "[INFO] Límites de velocidad por cuenta: " << velocityLimits.describe() << std::endl;
+        }
+
+        const char* scheduleFile = std::getenv("SCHEDULE_FILE");
+        scheduler.reset(new PaymentScheduler(scheduleFile ? scheduleFile : "",
+            static_cast<size_t>(std::max(1L, envLong("SCHEDULE_BATCH_SIZE", 1024))), envLong("SCHEDULE_FSYNC", 0) != 0));
+        if (!scheduler->persistent()) {
+            std::cout << "[WARNING] Transacciones programadas solo en memoria (SCHEDULE_FILE no definido)" << std::endl;
+        }
+
+        long ledgerPartitions = envLong("LEDGER_PARTITIONS", 0);
+        if (ledgerPartitions > 0) {
+            ledger.reset(new ShardExecutor(static_cast<size_t>(ledgerPartitions), accounts,
+                static_cast<size_t>(std::max(16L, envLong("LEDGER_QUEUE_CAPACITY", 4096))), velocityLimits));
+        }
+
+        // El ledger por particiones no usa locks, así que no tiene sentido dividir cuentas
+        splitThreshold = ledger ? 0 : static_cast<uint32_t>(std::max(0L, envLong("SPLIT_ACCOUNT_THRESHOLD", 0)));
+        unsigned int cores = std::thread::hardware_concurrency();
+        splitStripes = static_cast<size_t>(std::min(64L, std::max(2L, envLong("SPLIT_ACCOUNT_STRIPES", cores ? cores : 4))));
         
         std::cout << "[INFO] Servidor inicializado en puerto " << port << std::endl;
         std::cout << "[DEBUG] Clave AES tiene " << aesKey.length() << " bytes" << std::endl;
         std::cout << "[DEBUG] Clave secreta tiene " << secretKey.length() << " bytes" << std::endl;
-        std::cout << "[INFO] Cuentas de prueba disponibles:" << std::endl;
-        for (const auto& account : accounts) {
-            std::cout << "  - Cuenta: " << account.first << " Saldo: $" << account.second << std::endl;
+        if (accounts.size() <= 10) {
+            std::cout << "[INFO] Cuentas de prueba disponibles:" << std::endl;
+            for (const auto& account : accounts) {
+                std::cout << "  - Cuenta: " << account.first << " Saldo: $" << account.second.balance << std::endl;
+            }
+        } else {
+            std::cout << "[INFO] " << accounts.size() << " cuentas disponibles" << std::endl;
         }
     }
 
     bool start() {
+        if (!startupError.empty()) {
+            std::cerr << "[ERROR] " << startupError << std::endl;
+            return false;
+        }
+
+        if (!openListener()) {
+            return false;
+        }
+        // No bloqueante: con el socket compartido, otro proceso puede tomar la conexión
+        // entre el poll y el accept
+        fcntl(serverSocket, F_SETFL, fcntl(serverSocket, F_GETFL) | O_NONBLOCK);
+
+        // Después del traspaso: el proceso anterior ya cerró el registro
+        std::string scheduleError;
+        if (!scheduler->recover(scheduleError)) {
+            std::cerr << "[ERROR] No se pudieron recuperar las transacciones programadas: " << scheduleError << std::endl;
+            close(serverSocket);
+            serverSocket = -1;
+            return false;
+        }
+
+        if (!handoffPath.empty()) {
+            std::string handoffError;
+            controlSocket = ListenerHandoff::listen(handoffPath, handoffError);
+            if (controlSocket < 0) {
+                std::cerr << "[WARNING] Traspaso del socket de escucha desactivado: " << handoffError << std::endl;
+            } else {
+                std::cout << "[INFO] Traspaso del socket de escucha disponible en " << handoffPath << std::endl;
+            }
+        }
+
+        running = true;
+        std::cout << "[SUCCESS] Servidor escuchando en puerto " << port << std::endl;
+
+        if (ledger) {
+            ledger->start();
+        }
+        startWorkers();
+        reaper->start();
+        scheduler->start([this](std::vector<Transaction>& due) { executeScheduled(due); });
+
+        startMetricsEndpoint();
+        startAdminEndpoint();
+
+        std::cout << "[INFO] Esperando conexiones de clientes..." << std::endl;
+
+        return true;
+    }
+
+    // Socket de escucha heredado del proceso anterior por HANDOFF_SOCKET o uno nuevo
+    bool openListener() {
+        if (!handoffPath.empty()) {
+            std::string handoffError;
+            serverSocket = ListenerHandoff::request(handoffPath, handoffError);
+            if (serverSocket >= 0) {
+                struct sockaddr_in boundAddr;
+                socklen_t boundLen = sizeof(boundAddr);
+                if (getsockname(serverSocket, (struct sockaddr*)&boundAddr, &boundLen) == 0) {
+                    port = ntohs(boundAddr.sin_port);
+                }
+                std::cout << "[SUCCESS] Socket de escucha recibido del proceso anterior" << std::endl;
+                return true;
+            }
+            if (!handoffError.empty()) {
+                std::cerr << "[WARNING] No se pudo recibir el socket de escucha: " << handoffError << std::endl;
+            }
+        }
+
         serverSocket = socket(AF_INET, SOCK_STREAM, 0);
         if (serverSocket < 0) {
             std::cerr << "[ERROR] No se pudo crear el socket del servidor" << std::endl;
@@ -86,138 +346,723 @@ public:
             close(serverSocket);
             return false;
         }
+        return true;
+    }
 
-        running = true;
-        std::cout << "[SUCCESS] Servidor escuchando en puerto " << port << std::endl;
-        std::cout << "[INFO] Esperando conexiones de clientes..." << std::endl;
+    // METRICS_PORT=0 desactiva el endpoint; METRICS_ADDR permite exponerlo fuera del host
+    void startMetricsEndpoint() {
+        const char* envPort = std::getenv("METRICS_PORT");
+        const char* envAddr = std::getenv("METRICS_ADDR");
+        int metricsPort = envPort ? std::atoi(envPort) : 9100;
+        if (metricsPort <= 0) {
+            std::cout << "[INFO] Endpoint de métricas desactivado" << std::endl;
+            return;
+        }
+
+        metricsEndpoint.reset(new HttpEndpoint("metricas", envAddr ? envAddr : "127.0.0.1", metricsPort,
+            [](const std::string& method, const std::string& path, std::string& body) {
+                if (path != "/metrics") {
+                    return HttpEndpoint::NOT_FOUND;
+                }
+                if (method != "GET") {
+                    return HttpEndpoint::METHOD_NOT_ALLOWED;
+                }
+                body = Metrics::renderPrometheus();
+                return HttpEndpoint::OK;
+            }));
+        if (!metricsEndpoint->start()) {
+            std::cerr << "[WARNING] El servidor continuará sin endpoint de métricas" << std::endl;
+            metricsEndpoint.reset();
+        }
+    }
+
+    // Estado en vivo en ADMIN_PORT (por defecto 9101, 0 lo desactiva), solo local por defecto
+    void startAdminEndpoint() {
+        const char* envPort = std::getenv("ADMIN_PORT");
+        const char* envAddr = std::getenv("ADMIN_ADDR");
+        int adminPort = envPort ? std::atoi(envPort) : 9101;
+        if (adminPort <= 0) {
+            std::cout << "[INFO] Puerto de administración desactivado" << std::endl;
+            return;
+        }
+
+        adminEndpoint.reset(new HttpEndpoint("administracion", envAddr ? envAddr : "127.0.0.1", adminPort,
+            [this](const std::string& method, const std::string& path, std::string& body) {
+                // GET solo consulta; cambiar los límites exige POST
+                if (path == "/ratelimit" || path.compare(0, 11, "/ratelimit?") == 0) {
+                    if (method != "POST" && path != "/ratelimit") {
+                        body = "Use POST para cambiar los límites de tasa\n";
+                        return HttpEndpoint::METHOD_NOT_ALLOWED;
+                    }
+                    body = configureRateLimits(path);
+                    return HttpEndpoint::OK;
+                }
+                if (method != "GET") {
+                    return HttpEndpoint::METHOD_NOT_ALLOWED;
+                }
+                if (path == "/services/reload") {
+                    if (!services.enabled()) {
+                        body = "Catálogo de servicios desactivado (SERVICES_FILE no definido)\n";
+                    } else if (services.reloadAsync()) {
+                        body = "Recarga del catálogo de servicios iniciada\n";
+                    } else {
+                        body = "Ya hay una recarga del catálogo de servicios en curso\n";
+                    }
+                    return HttpEndpoint::OK;
+                }
+                if (path == "/ledger/audit") {
+                    body = ledger ? ledger->audit() : "Ledger por particiones desactivado (LEDGER_PARTITIONS=0)\n";
+                    return HttpEndpoint::OK;
+                }
+                if (path != "/status" && path != "/") {
+                    return HttpEndpoint::NOT_FOUND;
+                }
+                body = renderStatus();
+                return HttpEndpoint::OK;
+            }));
+        if (!adminEndpoint->start()) {
+            std::cerr << "[WARNING] El servidor continuará sin puerto de administración" << std::endl;
+            adminEndpoint.reset();
+        }
+    }
+
+    void startWorkers() {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        long count = std::max(1L, envLong("WORKER_THREADS", hardwareThreads ? hardwareThreads : 4));
+        // Solo se agrupan mensajes cuando hay más en espera que trabajadores,
+        // es decir, cuando ningún hilo libre podría atenderlos antes
+        cryptoBatchDepth = static_cast<size_t>(std::max(2L, envLong("CRYPTO_BATCH_DEPTH", count + 1)));
+        for (long i = 0; i < count; i++) {
+            workers.emplace_back(&TransactionServer::workerLoop, this);
+        }
+        std::cout << "[INFO] " << count << " hilos trabajadores, cola de " << workQueue->maxSize()
+                  << " mensajes, plazo en cola " << queueDeadline.count() << " ms, máximo "
+                  << maxConnections << " conexiones" << std::endl;
+    }
+
+    void workerLoop() {
+        std::vector<WorkItem> batch;
+        std::vector<std::string> plaintexts;
+        while (workQueue->popBatch(batch, cryptoBatchSize, cryptoBatchDepth)) {
+            if (batch.size() == 1) {
+                WorkItem& item = batch.front();
+                if (admitQueued(item)) {
+                    processTransaction(*item.message, *item.response, *item.session);
+                }
+                item.done.set_value();
+            } else {
+                processCryptoBatch(batch, plaintexts);
+            }
+        }
+    }
 
+    // Registra la espera en cola; un mensaje que esperó más que su plazo se
+    // rechaza antes de cualquier trabajo criptográfico
+    bool admitQueued(WorkItem& item) {
+        auto now = std::chrono::steady_clock::now();
+        Metrics::recordLatency(Metrics::Stage::QueueWait,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now - item.enqueuedAt).count());
+
+        if (now > item.deadline) {
+            shedRequests++;
+            Metrics::countError(Metrics::ErrorReason::Busy);
+            writeErrorResponse(*item.response, "Plazo de espera en cola vencido", "BUSY");
+            return false;
+        }
         return true;
     }
 
-    void run() {
+    // Verifica y descifra todos los mensajes del lote seguidos (mismo contexto HMAC
+    // y AES por hilo, claves ya expandidas y en caché) y después ejecuta los que
+    // pasaron. Cada conexión se libera en cuanto su respuesta está lista.
+    void processCryptoBatch(std::vector<WorkItem>& batch, std::vector<std::string>& plaintexts) {
+        cryptoBatches++;
+        cryptoBatchedMessages += batch.size();
+        plaintexts.resize(std::max(plaintexts.size(), batch.size()));
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            WorkItem& item = batch[i];
+            plaintexts[i].clear();
+            if (!admitQueued(item) ||
+                !openEnvelope(*item.message, plaintexts[i], *item.response, *item.session, item.viaSession)) {
+                item.done.set_value();
+                item.message = nullptr;
+            }
+        }
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            WorkItem& item = batch[i];
+            if (item.message) {
+                processPlaintext(plaintexts[i], *item.response, item.viaSession);
+                item.done.set_value();
+            }
+        }
+    }
+
+    // Encola el mensaje y espera a que un hilo trabajador escriba la respuesta en `response`
+    void submitTransaction(const std::string& message, std::string& response, SecureSession& session) {
+        WorkItem item;
+        item.message = &message;
+        item.response = &response;
+        item.session = &session;
+        item.enqueuedAt = std::chrono::steady_clock::now();
+        item.deadline = item.enqueuedAt + queueDeadline;
+        std::future<void> done = item.done.get_future();
+
+        if (!workQueue->tryPush(std::move(item))) {
+            shedRequests++;
+            Metrics::countError(Metrics::ErrorReason::Busy);
+            std::cout << "[WARNING] Cola de trabajo llena, mensaje rechazado" << std::endl;
+            writeErrorResponse(response, "Cola de trabajo llena", "BUSY");
+            return;
+        }
+        done.wait();
+    }
+
+    void stopWorkers() {
+        workQueue->close();
+        for (auto& worker : workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        workers.clear();
+    }
+
+    // Acepta conexiones hasta recibir una señal por `signalFd` (self-pipe) o traspasar
+    // el socket de escucha, y luego drena
+    void run(int signalFd) {
         while (running) {
-            struct sockaddr_in clientAddr;
-            socklen_t clientLen = sizeof(clientAddr);
-            
-            int clientSocket = accept(serverSocket, (struct sockaddr*)&clientAddr, &clientLen);
-            if (clientSocket < 0) {
-                if (running) {
-                    std::cerr << "[ERROR] Error al aceptar conexión del cliente" << std::endl;
+            struct pollfd fds[3] = {{serverSocket, POLLIN, 0}, {signalFd, POLLIN, 0}, {controlSocket, POLLIN, 0}};
+            if (poll(fds, controlSocket >= 0 ? 3 : 2, -1) < 0) {
+                if (errno != EINTR) {
+                    std::cerr << "[ERROR] poll: " << strerror(errno) << std::endl;
                 }
                 continue;
             }
+            if (fds[1].revents & POLLIN) {
+                int signal = 0;
+                if (read(signalFd, &signal, sizeof(signal)) != sizeof(signal)) {
+                    signal = 0;
+                }
+                std::cout << "\n[INFO] Señal recibida (" << signal << "). Deteniendo servidor..." << std::endl;
+                break;
+            }
+            if (controlSocket >= 0 && (fds[2].revents & POLLIN) && handOff()) {
+                break;
+            }
+            if (fds[0].revents & POLLIN) {
+                acceptClient();
+            }
+        }
+        drain();
+    }
 
-            std::cout << "[INFO] Nueva conexión de cliente aceptada" << std::endl;
-            
-            // Manejar cliente en un hilo separado
-            std::thread clientThread(&TransactionServer::handleClient, this, clientSocket);
-            clientThread.detach();
+    void acceptClient() {
+        struct sockaddr_in clientAddr;
+        socklen_t clientLen = sizeof(clientAddr);
+        
+        int clientSocket = accept(serverSocket, (struct sockaddr*)&clientAddr, &clientLen);
+        if (clientSocket < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+                std::cerr << "[ERROR] Error al aceptar conexión del cliente: " << strerror(errno) << std::endl;
+                // Sin descriptores o memoria el socket sigue legible: esperar en vez de girar
+                if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+            }
+            return;
         }
+
+        // Por encima del límite la conexión se rechaza de inmediato en vez de crear otro hilo
+        if (activeConnections.load() >= maxConnections) {
+            rejectedConnections++;
+            Metrics::countError(Metrics::ErrorReason::Busy);
+            std::string response;
+            writeErrorResponse(response, "Demasiadas conexiones", "BUSY");
+            response.push_back('\n');
+            FrameWriter::sendAll(clientSocket, response);
+            close(clientSocket);
+            std::cout << "[WARNING] Conexión rechazada: límite de " << maxConnections << " alcanzado" << std::endl;
+            return;
+        }
+
+        std::cout << "[INFO] Nueva conexión de cliente aceptada" << std::endl;
+        acceptedConnections++;
+        activeConnections++;
+        
+        // Manejar cliente en un hilo separado
+        char clientIp[INET_ADDRSTRLEN] = "";
+        inet_ntop(AF_INET, &clientAddr.sin_addr, clientIp, sizeof(clientIp));
+        std::thread clientThread(&TransactionServer::handleClient, this, clientSocket, std::string(clientIp));
+        clientThread.detach();
     }
 
-    void handleClient(int clientSocket) {
-        char buffer[4096];
-        std::string receivedData;
+    // Un proceso nuevo pidió el socket de escucha: se le envía y este proceso drena
+    bool handOff() {
+        int peer = accept(controlSocket, nullptr, nullptr);
+        if (peer < 0) {
+            return false;
+        }
+        std::string error;
+        if (!ListenerHandoff::send(peer, serverSocket, error)) {
+            close(peer);
+            std::cerr << "[WARNING] Traspaso del socket de escucha fallido: " << error << std::endl;
+            return false;
+        }
+        // Lo que no se comparte se libera antes de confirmar: el proceso nuevo espera
+        // la confirmación para abrir el registro de programadas y los puertos HTTP
+        scheduler->stop();
+        if (metricsEndpoint) {
+            metricsEndpoint->stop();
+        }
+        if (adminEndpoint) {
+            adminEndpoint->stop();
+        }
+        ListenerHandoff::release(peer);
+        close(peer);
+        handedOff = true;
+        std::cout << "[INFO] Socket de escucha traspasado a un proceso nuevo. Drenando conexiones..." << std::endl;
+        return true;
+    }
 
-        while (true) {
-            memset(buffer, 0, sizeof(buffer));
-            int bytesReceived = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
-            
-            if (bytesReceived <= 0) {
-                std::cout << "[INFO] Cliente desconectado" << std::endl;
-                break;
+    // Deja de aceptar, corta la lectura de todas las conexiones (las que esperan un
+    // mensaje se cierran; las que tienen uno en curso lo terminan y responden) y espera
+    // hasta drainTimeout. Las que sigan abiertas se cierran del todo. Después se detienen
+    // los trabajadores y el ledger; el planificador (con su registro en disco) ya se
+    // detuvo al empezar. Si una conexión no termina ni así, el proceso sale con _exit.
+    void drain() {
+        draining = true;
+        close(serverSocket);
+        serverSocket = -1;
+        if (controlSocket >= 0) {
+            close(controlSocket);
+            controlSocket = -1;
+            // El proceso nuevo ya reemplazó el socket de control por el suyo
+            if (!handedOff) {
+                unlink(handoffPath.c_str());
+            }
+        }
+        scheduler->stop();
+
+        size_t open = reaper->shutdownAll(SHUT_RD);
+        std::cout << "[INFO] Drenando " << open << " conexiones (plazo " << drainTimeout.count() << " ms)" << std::endl;
+        if (!waitConnections(drainTimeout)) {
+            size_t forced = reaper->shutdownAll(SHUT_RDWR);
+            std::cout << "[WARNING] Plazo de drenaje vencido: se cierran " << forced << " conexiones" << std::endl;
+            // Las que esperan a un trabajador se liberan cuando este termina
+            if (!waitConnections(std::chrono::milliseconds(1000))) {
+                // Sus hilos (desacoplados) siguen usando el servidor: destruirlo sería
+                // un uso después de liberar. El registro de programadas ya se cerró.
+                std::cout << "[ERROR] " << activeConnections.load()
+                          << " conexiones no terminaron; se termina el proceso sin liberar recursos" << std::endl;
+                _exit(1);
             }
+        }
+        stop();
+    }
 
-            receivedData += std::string(buffer, bytesReceived);
-            
-            // Verificar si recibimos un mensaje completo (terminado en \n)
-            size_t pos = receivedData.find('\n');
-            if (pos != std::string::npos) {
-                std::string message = receivedData.substr(0, pos);
-                receivedData = receivedData.substr(pos + 1);
-                
-                std::string response = processTransaction(message);
-                send(clientSocket, response.c_str(), response.length(), 0);
+    bool waitConnections(std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (activeConnections.load() > 0) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
             }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
+        return true;
+    }
 
+    void handleClient(int clientSocket, std::string clientIp) {
+        ConnectionReaper::Phase expired;
+        {
+            ConnectionReaper::Timer timer(*reaper, clientSocket);
+            serveClient(clientSocket, clientIp, timer);
+            expired = timer.expired();
+        }
+        // Ya fuera de la rueda: el reaper no puede hacer shutdown de un fd reutilizado
+        if (expired != ConnectionReaper::Phase::Busy) {
+            std::cout << "[WARNING] Conexión de " << clientIp << " cerrada por plazo vencido ("
+                      << (expired == ConnectionReaper::Phase::Idle ? "inactividad"
+                          : expired == ConnectionReaper::Phase::Frame ? "mensaje incompleto" : "envío")
+                      << ")" << std::endl;
+        }
         close(clientSocket);
+        activeConnections--;
+    }
+
+    // Atiende los mensajes de la conexión hasta que se cierra o vence un plazo
+    void serveClient(int clientSocket, const std::string& clientIp, ConnectionReaper::Timer& timer) {
+        // Búferes de lectura, mensaje y respuesta reutilizados por todos los mensajes de la conexión
+        FrameReader reader(clientSocket, maxFrameBytes);
+        std::string message;
+        std::string response;
+        response.reserve(512);
+        // Claves de sesión negociadas en esta conexión (si el cliente hace el handshake)
+        SecureSession session;
+
+        // Plazo de inactividad entre mensajes; desde el primer byte, el de recepción del
+        // mensaje completo (un resto ya recibido lo cuenta desde que llegó)
+        reader.onMessageStart([&timer]() { timer.arm(ConnectionReaper::Phase::Frame); });
+        auto armRead = [&]() {
+            if (reader.buffered()) {
+                timer.armAt(ConnectionReaper::Phase::Frame, reaper->toMillis(reader.pendingStarted()));
+            } else {
+                timer.arm(ConnectionReaper::Phase::Idle);
+            }
+        };
+
+        // Se atienden todos los mensajes completos recibidos: un cliente puede enviar
+        // varios sin esperar respuesta, que se devuelven en el mismo orden
+        // Al drenar se termina el mensaje en curso y no se leen más
+        std::string_view frame;
+        FrameReader::Status status = FrameReader::Status::Closed;
+        armRead();
+        while (!draining && (status = reader.next(frame)) == FrameReader::Status::Frame) {
+            timer.arm(ConnectionReaper::Phase::Busy);
+            Metrics::recordLatency(Metrics::Stage::FrameRead, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - reader.frameStarted()).count());
+            message.assign(frame.data(), frame.size());
+
+            // El límite por IP se aplica antes de encolar: rechazar no cuesta ni una operación criptográfica
+            response.clear();
+            if (!ipLimiter.allow(clientIp)) {
+                Metrics::countError(Metrics::ErrorReason::RateLimited);
+                std::cout << "[WARNING] Límite de tasa excedido para la IP " << clientIp << std::endl;
+                writeErrorResponse(response, "Límite de tasa excedido por IP", "RATE_LIMITED");
+            } else {
+                submitTransaction(message, response, session);
+            }
+            response.push_back('\n'); // Terminador de respuesta
+
+            StageTimer sendTimer(Metrics::Stage::ResponseSend);
+            timer.arm(ConnectionReaper::Phase::Write);
+            if (!FrameWriter::sendAll(clientSocket, response)) {
+                std::cout << "[WARNING] No se pudo enviar la respuesta: " << strerror(errno) << std::endl;
+                break;
+            }
+            sendTimer.stop();
+            armRead();
+        }
+
+        if (status == FrameReader::Status::TooLarge) {
+            std::cout << "[WARNING] Mensaje supera " << maxFrameBytes << " bytes, se cierra la conexión" << std::endl;
+            Metrics::countError(Metrics::ErrorReason::InvalidFormat);
+            response.clear();
+            writeErrorResponse(response, "Mensaje demasiado grande");
+            response.push_back('\n');
+            timer.arm(ConnectionReaper::Phase::Write);
+            FrameWriter::sendAll(clientSocket, response);
+        } else if (timer.expired() == ConnectionReaper::Phase::Busy) {
+            std::cout << "[INFO] Cliente desconectado" << std::endl;
+        }
+    }
+
+    // Escribe la respuesta en `out`, que llega vacío
+    void processTransaction(const std::string& encryptedMessage, std::string& out, SecureSession& session) {
+        std::string decryptedData;
+        bool viaSession = false;
+        if (openEnvelope(encryptedMessage, decryptedData, out, session, viaSession)) {
+            processPlaintext(decryptedData, out, viaSession);
+        }
     }
 
-    std::string processTransaction(const std::string& encryptedMessage) {
+    // Etapa criptográfica: separa el sobre "IV:ENCRYPTED_DATA:HMAC", verifica el HMAC
+    // y descifra en `decryptedData`. Si falla escribe el error en `out` y devuelve false.
+    // También atiende el handshake de sesión y los mensajes "S:<seq>:..." de una sesión.
+    bool openEnvelope(const std::string& encryptedMessage, std::string& decryptedData, std::string& out,
+                      SecureSession& session, bool& viaSession) {
         std::cout << "[INFO] Procesando transacción recibida..." << std::endl;
 
         try {
+            if (encryptedMessage.compare(0, 6, "HELLO|") == 0) {
+                acceptHandshake(encryptedMessage, session, out);
+                return false;
+            }
+            if (SecureSession::isSessionMessage(encryptedMessage)) {
+                viaSession = true;
+                return openSessionMessage(encryptedMessage, session, decryptedData, out);
+            }
+
             // Parsear el mensaje: formato "IV:ENCRYPTED_DATA:HMAC"
             size_t firstColon = encryptedMessage.find(':');
             size_t secondColon = encryptedMessage.find(':', firstColon + 1);
             
             if (firstColon == std::string::npos || secondColon == std::string::npos) {
-                return createErrorResponse("Formato de mensaje inválido");
+                Metrics::countError(Metrics::ErrorReason::InvalidFormat);
+                writeErrorResponse(out, "Formato de mensaje inválido");
+                return false;
             }
 
-            std::string iv = encryptedMessage.substr(0, firstColon);
-            std::string encryptedData = encryptedMessage.substr(firstColon + 1, secondColon - firstColon - 1);
-            std::string receivedHMAC = encryptedMessage.substr(secondColon + 1);
+            // Vistas sobre el mensaje recibido: ninguna parte del sobre se copia
+            std::string_view envelope(encryptedMessage);
+            std::string_view iv = envelope.substr(0, firstColon);
+            std::string_view encryptedData = envelope.substr(firstColon + 1, secondColon - firstColon - 1);
+            std::string_view receivedHMAC = envelope.substr(secondColon + 1);
 
             std::cout << "[DEBUG] IV Base64 recibido: " << iv.substr(0, 20) << "..." << std::endl;
             std::cout << "[DEBUG] Datos cifrados recibidos: " << encryptedData.length() << " caracteres" << std::endl;
             std::cout << "[DEBUG] HMAC recibido: " << receivedHMAC.substr(0, 16) << "..." << std::endl;
 
             // Decodificar IV de Base64
+            StageTimer decodeTimer(Metrics::Stage::Base64Decode);
             std::vector<unsigned char> ivBytes = CryptoUtils::base64Decode(iv);
             if (ivBytes.size() != 16) {
                 std::cout << "[ERROR] IV debe ser de 16 bytes, recibido: " << ivBytes.size() << " bytes" << std::endl;
-                return createErrorResponse("IV inválido");
+                Metrics::countError(Metrics::ErrorReason::InvalidIV);
+                writeErrorResponse(out, "IV inválido");
+                return false;
             }
             std::string ivDecoded(ivBytes.begin(), ivBytes.end());
 
+            std::vector<unsigned char> encryptedBytes = CryptoUtils::base64Decode(encryptedData);
+            decodeTimer.stop();
+
             std::cout << "[DEBUG] IV decodificado: " << ivBytes.size() << " bytes" << std::endl;
 
             // Verificar HMAC
-            std::string dataToVerify = iv + ":" + encryptedData;
-            if (!CryptoUtils::verifyHMAC(dataToVerify, receivedHMAC, secretKey)) {
+            StageTimer hmacTimer(Metrics::Stage::HmacVerify);
+            if (!CryptoUtils::verifyHMAC({iv, ":", encryptedData}, receivedHMAC, secretKey)) {
                 std::cout << "[ERROR] HMAC inválido - posible manipulación de datos" << std::endl;
-                return createErrorResponse("Verificación de integridad fallida");
+                Metrics::countError(Metrics::ErrorReason::IntegrityCheck);
+                writeErrorResponse(out, "Verificación de integridad fallida");
+                return false;
             }
+            hmacTimer.stop();
 
             // Descifrar datos
-            std::string decryptedData = CryptoUtils::decryptAES256(encryptedData, aesKey, ivDecoded);
+            StageTimer aesTimer(Metrics::Stage::AesDecrypt);
+            decryptedData = encryptedBytes.empty()
+                ? std::string()
+                : CryptoUtils::decryptAES256(encryptedBytes, aesKey, ivDecoded);
             if (decryptedData.empty()) {
                 std::cout << "[ERROR] Error al descifrar los datos" << std::endl;
-                return createErrorResponse("Error de descifrado");
+                Metrics::countError(Metrics::ErrorReason::DecryptFailed);
+                writeErrorResponse(out, "Error de descifrado");
+                return false;
             }
+            aesTimer.stop();
 
             std::cout << "[SUCCESS] Datos descifrados correctamente" << std::endl;
             std::cout << "[DEBUG] Datos descifrados: " << decryptedData.substr(0, 100) << "..." << std::endl;
             std::cout << "[DEBUG] Longitud de datos descifrados: " << decryptedData.length() << " bytes" << std::endl;
+            return true;
+
+        } catch (const std::exception& e) {
+            failInternal(e, out);
+            return false;
+        }
+    }
+
+    // Handshake "HELLO|<nonce_cliente>|<hmac>" -> "SESSION|<nonce_servidor>|<hmac>".
+    // Ambos lados derivan la clave de sesión; un nuevo handshake la reemplaza.
+    void acceptHandshake(const std::string& message, SecureSession& session, std::string& out) {
+        std::string_view hello(message);
+        size_t separator = hello.find('|', 6);
+        if (separator == std::string_view::npos) {
+            Metrics::countError(Metrics::ErrorReason::InvalidFormat);
+            writeErrorResponse(out, "Handshake inválido");
+            return;
+        }
+        std::string_view clientNonce = hello.substr(6, separator - 6);
+
+        StageTimer hmacTimer(Metrics::Stage::HmacVerify);
+        if (!CryptoUtils::verifyHMAC({"HELLO|", clientNonce}, hello.substr(separator + 1), secretKey)) {
+            std::cout << "[ERROR] Handshake con HMAC inválido" << std::endl;
+            Metrics::countError(Metrics::ErrorReason::IntegrityCheck);
+            writeErrorResponse(out, "Verificación de integridad fallida");
+            return;
+        }
+        hmacTimer.stop();
+
+        std::vector<unsigned char> clientBytes = CryptoUtils::base64Decode(clientNonce);
+        unsigned char serverBytes[SecureSession::HANDSHAKE_NONCE_LENGTH];
+        if (clientBytes.size() != SecureSession::HANDSHAKE_NONCE_LENGTH) {
+            Metrics::countError(Metrics::ErrorReason::InvalidFormat);
+            writeErrorResponse(out, "Handshake inválido");
+            return;
+        }
+        if (!CryptoUtils::fillRandomBytes(serverBytes, sizeof(serverBytes)) ||
+            !session.establish(secretKey, aesKey, clientBytes.data(), serverBytes)) {
+            Metrics::countError(Metrics::ErrorReason::InternalError);
+            writeErrorResponse(out, "Error interno del servidor");
+            return;
+        }
+
+        char serverChars[24];
+        std::string_view serverNonce(serverChars,
+            CryptoUtils::base64Encode(serverBytes, sizeof(serverBytes), serverChars));
+        ResponseWriter writer(out);
+        writer << "SESSION|" << serverNonce << '|'
+               << SecureSession::sessionTag(secretKey, clientNonce, serverNonce);
+        sessionsEstablished++;
+        std::cout << "[SUCCESS] Sesión establecida" << std::endl;
+    }
+
+    // Un mensaje de sesión se autentica y descifra con una sola operación AES-GCM; el
+    // número de secuencia creciente reemplaza al token dinámico como prueba de frescura
+    bool openSessionMessage(const std::string& message, SecureSession& session,
+                            std::string& decryptedData, std::string& out) {
+        if (!session.isEstablished()) {
+            Metrics::countError(Metrics::ErrorReason::InvalidFormat);
+            writeErrorResponse(out, "Sesión no establecida");
+            return false;
+        }
+
+        StageTimer aesTimer(Metrics::Stage::AesDecrypt);
+        if (!session.open(message, decryptedData)) {
+            std::cout << "[ERROR] Mensaje de sesión rechazado (secuencia " << session.lastSequence()
+                      << " ya usada o datos manipulados)" << std::endl;
+            Metrics::countError(Metrics::ErrorReason::IntegrityCheck);
+            writeErrorResponse(out, "Verificación de integridad fallida");
+            return false;
+        }
+        return true;
+    }
+
+    // Etapa posterior al descifrado: parseo, límites, token, ejecución y respuesta.
+    // En una sesión el token dinámico no se valida: la frescura la da la secuencia.
+    void processPlaintext(const std::string& decryptedData, std::string& out, bool sessionAuthenticated) {
+        try {
+            // Un lote comparte IV, HMAC y token: se procesa completo en un solo mensaje
+            if (decryptedData.compare(0, 6, "BATCH|") == 0) {
+                processBatch(decryptedData, out, sessionAuthenticated);
+                return;
+            }
 
             // Parsear la transacción
+            StageTimer parseTimer(Metrics::Stage::Parse);
             Transaction transaction = parseTransaction(decryptedData);
+            parseTimer.stop();
+
+            // El límite por cuenta se evalúa antes de la validación del token, la etapa más
+            // costosa; si el token no es válido el permiso se devuelve, así que quien no
+            // tiene el secreto no puede gastar el presupuesto de una cuenta ajena
+            if (!accountLimiter.allow(rateLimitKey(transaction))) {
+                Metrics::countError(Metrics::ErrorReason::RateLimited);
+                std::cout << "[WARNING] Límite de tasa excedido para la cuenta " << rateLimitKey(transaction) << std::endl;
+                writeErrorResponse(out, "Límite de tasa excedido por cuenta", "RATE_LIMITED");
+                return;
+            }
             
             // Validar token dinámico
-            if (!CryptoUtils::validateDynamicToken(transaction.dynamicToken, secretKey, transaction.id)) {
-                std::cout << "[ERROR] Token dinámico inválido o expirado" << std::endl;
-                return createErrorResponse("Token dinámico inválido");
+            if (!sessionAuthenticated) {
+                StageTimer tokenTimer(Metrics::Stage::TokenValidation);
+                if (!CryptoUtils::validateDynamicToken(transaction.dynamicToken, secretKey, transaction.id)) {
+                    accountLimiter.refund(rateLimitKey(transaction));
+                    std::cout << "[ERROR] Token dinámico inválido o expirado" << std::endl;
+                    Metrics::countError(Metrics::ErrorReason::InvalidToken);
+                    writeErrorResponse(out, "Token dinámico inválido");
+                    return;
+                }
+                tokenTimer.stop();
+
+                std::cout << "[SUCCESS] Token dinámico válido" << std::endl;
             }
 
-            std::cout << "[SUCCESS] Token dinámico válido" << std::endl;
+            if (!transaction.scheduledAt.empty() && scheduleTransaction(transaction, out)) {
+                return;
+            }
 
             // Procesar la transacción según su tipo
-            std::string result = executeTransaction(transaction);
+            StageTimer executeTimer(Metrics::Stage::Execute);
+            ExecutionOutcome outcome = executeTransaction(transaction);
+            executeTimer.stop();
+            countResult(transaction.type, outcome);
             
             // Registrar en historial
+            TransactionRecord record = TransactionRecord::pack(transaction, historyStrings);
             {
                 std::lock_guard<std::mutex> lock(historyMutex);
-                transactionHistory.push_back(transaction);
+                transactionHistory.push_back(record);
+            }
+            historySize++;
+
+            // Respuesta armada fuera de los locks, directamente en el búfer de la conexión
+            ResponseWriter writer(out);
+            writeSuccessHeader(writer, transaction.id);
+            size_t resultStart = writer.size();
+            formatResult(transaction, outcome, writer);
+            if (outcome.ok()) {
+                std::cout << "[SUCCESS] " << std::string_view(out).substr(resultStart) << std::endl;
             }
-
-            return createSuccessResponse(result, transaction.id);
 
         } catch (const std::exception& e) {
-            std::cout << "[ERROR] Excepción al procesar transacción: " << e.what() << std::endl;
-            return createErrorResponse("Error interno del servidor");
+            failInternal(e, out);
+        }
+    }
+
+    // Transacción con fecha de ejecución: si ya venció se ejecuta como cualquier otra
+    // (devuelve false); si no, se valida lo posible y queda en el planificador
+    bool scheduleTransaction(const Transaction& t, std::string& out) {
+        int64_t dueMillis;
+        if (!CryptoUtils::parseTimestamp(t.scheduledAt, dueMillis)) {
+            Metrics::countError(Metrics::ErrorReason::InvalidFormat);
+            writeErrorResponse(out, "Fecha de ejecución inválida");
+            return true;
+        }
+        int64_t nowMillis = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        if (dueMillis <= nowMillis) {
+            return false;
+        }
+
+        ResponseWriter writer(out);
+        writeSuccessHeader(writer, t.id);
+        const char* error = (this->*handlerOf(t.type).admitScheduled)(t);
+        std::string scheduleError;
+        if (!error && !scheduler->schedule(t, dueMillis, scheduleError)) {
+            std::cout << "[ERROR] No se pudo programar " << t.id << ": " << scheduleError << std::endl;
+            error = "ERROR: No se pudo programar la transacción";
+        }
+        if (error) {
+            ExecutionOutcome outcome;
+            outcome.error = error;
+            countResult(t.type, outcome);
+            writer << std::string_view(error);
+            return true;
+        }
+        writer << "SCHEDULED - " << transactionTypeName(t.type) << " de $" << t.amount << " programado para "
+               << t.scheduledAt;
+        std::cout << "[SUCCESS] Transacción " << t.id << " programada para " << t.scheduledAt << std::endl;
+        return true;
+    }
+
+    // Lote de transacciones programadas vencidas, desde el hilo del planificador: pasan
+    // por el mismo camino que una transacción recibida (locks o ledger, validación,
+    // límites de velocidad, métricas e historial)
+    void executeScheduled(std::vector<Transaction>& due) {
+        std::vector<TransactionRecord> records;
+        records.reserve(due.size());
+        size_t failed = 0;
+        for (const Transaction& t : due) {
+            ExecutionOutcome outcome;
+            try {
+                outcome = executeTransaction(t);
+            } catch (const std::exception& e) {
+                outcome.error = "ERROR: Error interno del servidor";
+            }
+            countResult(t.type, outcome);
+            records.push_back(TransactionRecord::pack(t, historyStrings));
+            if (!outcome.ok()) {
+                failed++;
+                std::cout << "[WARNING] Transacción programada " << t.id << " no ejecutada: " << outcome.error << std::endl;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(historyMutex);
+            transactionHistory.insert(transactionHistory.end(), records.begin(), records.end());
         }
+        historySize += records.size();
+        std::cout << "[INFO] " << due.size() << " transacciones programadas ejecutadas (" << failed
+                  << " rechazadas)" << std::endl;
+    }
+
+    void failInternal(const std::exception& e, std::string& out) {
+        std::cout << "[ERROR] Excepción al procesar transacción: " << e.what() << std::endl;
+        Metrics::countError(Metrics::ErrorReason::InternalError);
+        out.clear();
+        writeErrorResponse(out, "Error interno del servidor");
     }
 
     Transaction parseTransaction(const std::string& data) {
@@ -238,15 +1083,18 @@ public:
         if (parts.size() >= 8) {
             t.id = parts[0];
             t.timestamp = parts[1];
-            t.type = parts[2];
+            t.type = transactionTypeFromString(parts[2]);
             t.amount = std::stod(parts[3]);
             t.accountFrom = parts[4];
             t.accountTo = parts[5];
             t.serviceCode = parts[6];
             t.dynamicToken = parts[7];
+            if (parts.size() >= 10) {
+                t.scheduledAt = parts[9];
+            }
             
             std::cout << "[DEBUG] Transaction ID parseado: '" << t.id << "'" << std::endl;
-            std::cout << "[DEBUG] Tipo: '" << t.type << "'" << std::endl;
+            std::cout << "[DEBUG] Tipo: '" << parts[2] << "'" << std::endl;
             std::cout << "[DEBUG] Token: '" << t.dynamicToken.substr(0, 16) << "...'" << std::endl;
         } else {
             std::cout << "[ERROR] Datos de transacción incompletos. Partes: " << parts.size() << std::endl;
@@ -258,153 +1106,800 @@ public:
         return t;
     }
 
-    std::string executeTransaction(const Transaction& t) {
-        std::lock_guard<std::mutex> lock(accountsMutex);
+    // Manejadores de un tipo de transacción, generados a partir de su TransactionPolicy
+    struct TransactionHandler {
+        ExecutionOutcome (TransactionServer::*execute)(const Transaction&); // toma sus propios locks
+        ExecutionOutcome (TransactionServer::*apply)(const Transaction&);   // con los locks ya tomados
+        std::vector<size_t> (TransactionServer::*shards)(const Transaction&) const;
+        const char* (TransactionServer::*admitScheduled)(const Transaction&) const;
+        Metrics::TxType metric;
+    };
+
+    template <TransactionType Type>
+    static constexpr TransactionHandler handlerFor() {
+        return TransactionHandler{&TransactionServer::executeAs<Type>, &TransactionServer::applyAs<Type>,
+                                  &TransactionServer::shardsFor<Type>, &TransactionServer::admitScheduledAs<Type>,
+                                  TransactionPolicy<Type>::metric};
+    }
 
-        std::cout << "[INFO] Ejecutando transacción tipo: " << t.type << std::endl;
-        std::cout << "[INFO] ID Transacción: " << t.id << std::endl;
-        std::cout << "[INFO] Monto: $" << t.amount << std::endl;
+    // Un acceso indexado por el enum en lugar de comparar el texto del tipo
+    static const TransactionHandler& handlerOf(TransactionType type) {
+        static constexpr TransactionHandler HANDLERS[] = {
+            handlerFor<TransactionType::Transfer>(),
+            handlerFor<TransactionType::Balance>(),
+            handlerFor<TransactionType::Payment>(),
+            handlerFor<TransactionType::Deposit>(),
+            handlerFor<TransactionType::Unknown>(),
+        };
+        static_assert(sizeof(HANDLERS) / sizeof(HANDLERS[0]) == TRANSACTION_TYPE_COUNT,
+                      "Falta el manejador de algún tipo de transacción");
+        return HANDLERS[static_cast<size_t>(type)];
+    }
+
+    ExecutionOutcome executeTransaction(const Transaction& t) {
+        return (this->*handlerOf(t.type).execute)(t);
+    }
+
+    // Requiere que el llamador tenga los locks de los fragmentos de la transacción
+    ExecutionOutcome dispatchTransaction(const Transaction& t) {
+        return (this->*handlerOf(t.type).apply)(t);
+    }
 
-        if (t.type == "TRANSFER") {
+    std::vector<size_t> shardsOf(const Transaction& t) const {
+        return (this->*handlerOf(t.type).shards)(t);
+    }
+
+    template <TransactionType Type>
+    ExecutionOutcome executeAs(const Transaction& t) {
+        if (ledger) {
+            recordExecution(t);
+            if (const char* error = checkTransaction<Type>(t)) {
+                return failure(error);
+            }
+            return ledger->execute(t);
+        }
+        auto locks = lockShards(shardsFor<Type>(t));
+        ExecutionOutcome outcome = applyAs<Type>(t);
+        if constexpr (TransactionPolicy<Type>::usesTo) {
+            if (splitThreshold > 0 && outcome.ok()) {
+                maybeSplit(t.accountTo);
+            }
+        }
+        return outcome;
+    }
+
+    template <TransactionType Type>
+    ExecutionOutcome applyAs(const Transaction& t) {
+        recordExecution(t);
+        if (const char* error = checkTransaction<Type>(t)) {
+            return failure(error);
+        }
+
+        if constexpr (Type == TransactionType::Transfer) {
             return processTransfer(t);
-        } else if (t.type == "BALANCE") {
+        } else if constexpr (Type == TransactionType::Balance) {
             return processBalance(t);
-        } else if (t.type == "PAYMENT") {
+        } else if constexpr (Type == TransactionType::Payment) {
             return processPayment(t);
-        } else if (t.type == "DEPOSIT") {
+        } else if constexpr (Type == TransactionType::Deposit) {
             return processDeposit(t);
         } else {
-            return "ERROR: Tipo de transacción no soportado";
+            return failure("ERROR: Tipo de transacción no soportado");
         }
     }
 
-    std::string processTransfer(const Transaction& t) {
-        if (accounts.find(t.accountFrom) == accounts.end()) {
-            return "ERROR: Cuenta origen no existe";
+    // Lo que se puede validar al programar; el saldo y los límites de velocidad se
+    // evalúan al ejecutar
+    template <TransactionType Type>
+    const char* admitScheduledAs(const Transaction& t) const {
+        if constexpr (!TransactionPolicy<Type>::schedulable) {
+            (void)t;
+            return "ERROR: Tipo de transacción no programable";
+        } else {
+            if (const char* error = checkTransaction<Type>(t)) {
+                return error;
+            }
+            if constexpr (TransactionPolicy<Type>::usesFrom) {
+                if (accounts.find(t.accountFrom) == accounts.end()) {
+                    return "ERROR: Cuenta origen no existe";
+                }
+            }
+            if constexpr (TransactionPolicy<Type>::usesTo) {
+                if (accounts.find(t.accountTo) == accounts.end()) {
+                    return "ERROR: Cuenta destino no existe";
+                }
+            }
+            return nullptr;
+        }
+    }
+
+    // Validación de la política más la que depende del estado del servidor
+    template <TransactionType Type>
+    const char* checkTransaction(const Transaction& t) const {
+        if (const char* error = validateTransaction<Type>(t)) {
+            return error;
+        }
+        if constexpr (TransactionPolicy<Type>::paysService) {
+            if (!services.contains(t.serviceCode)) {
+                return "ERROR: Código de servicio no registrado";
+            }
+        }
+        return nullptr;
+    }
+
+    size_t shardOf(const std::string& account) const {
+        return std::hash<std::string>{}(account) % ACCOUNT_SHARDS;
+    }
+
+    // Solo las cuentas que el tipo usa. Las cuentas divididas no usan el lock de su
+    // fragmento: sus franjas tienen los suyos.
+    template <TransactionType Type>
+    std::vector<size_t> shardsFor(const Transaction& t) const {
+        std::vector<size_t> shards;
+        if constexpr (TransactionPolicy<Type>::usesFrom) {
+            addShard(t.accountFrom, shards);
+        }
+        if constexpr (TransactionPolicy<Type>::usesTo) {
+            addShard(t.accountTo, shards);
+        }
+        return shards;
+    }
+
+    void addShard(const std::string& account, std::vector<size_t>& shards) const {
+        if (account.empty()) {
+            return;
         }
-        if (accounts.find(t.accountTo) == accounts.end()) {
-            return "ERROR: Cuenta destino no existe";
+        auto it = accounts.find(account);
+        if (it == accounts.end() || !it->second.splitBalance()) {
+            shards.push_back(shardOf(account));
         }
-        if (accounts[t.accountFrom] < t.amount) {
+    }
+
+    // Operaciones sobre el saldo; para una cuenta simple requieren el lock de su fragmento
+    static double balanceOf(AccountRecord& account) {
+        SplitBalance* split = account.splitBalance();
+        return split ? split->read() : account.balance;
+    }
+
+    // En una cuenta dividida el saldo devuelto es aproximado (`approximate`): el
+    // crédito solo toma una franja y no ve una foto consistente de las demás
+    double credit(AccountRecord& account, double amount, bool& approximate) {
+        if (SplitBalance* split = account.splitBalance()) {
+            approximate = true;
+            return split->credit(amount);
+        }
+        if (splitThreshold > 0) {
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            if (now - account.creditWindowStart > 1000000000LL) {
+                account.creditWindowStart = now;
+                account.creditsInWindow = 0;
+            }
+            account.creditsInWindow++;
+        }
+        account.balance += amount;
+        return account.balance;
+    }
+
+    // Débito con los límites de velocidad; devuelve el error o nullptr si se aplicó.
+    // Los contadores se consultan y actualizan bajo el mismo lock que el saldo: el
+    // del fragmento o, en una cuenta dividida, todas sus franjas.
+    const char* debit(AccountRecord& account, double amount, double& balanceAfter) {
+        if (!velocityLimits.enabled()) {
+            return debitBalance(account, amount, balanceAfter) ? nullptr : "ERROR: Saldo insuficiente";
+        }
+
+        std::optional<SplitBalance::Exclusive> hold;
+        if (SplitBalance* split = account.splitBalance()) {
+            hold.emplace(*split);
+        }
+        uint64_t now = VelocityCounters::nowMillis();
+        int window = account.velocity.exceeded(now, amount, velocityLimits);
+        if (window >= 0) {
+            velocityRejections++;
+            return VelocityLimits::error(static_cast<size_t>(window));
+        }
+        if (!debitBalance(account, amount, balanceAfter)) {
             return "ERROR: Saldo insuficiente";
         }
+        account.velocity.record(now, amount);
+        return nullptr;
+    }
 
-        accounts[t.accountFrom] -= t.amount;
-        accounts[t.accountTo] += t.amount;
+    static bool debitBalance(AccountRecord& account, double amount, double& balanceAfter) {
+        if (SplitBalance* split = account.splitBalance()) {
+            return split->debit(amount, balanceAfter);
+        }
+        if (account.balance < amount) {
+            return false;
+        }
+        account.balance -= amount;
+        balanceAfter = account.balance;
+        return true;
+    }
 
-        std::stringstream ss;
-        ss << "TRANSFER SUCCESS - $" << t.amount << " transferidos de " 
-           << t.accountFrom << " a " << t.accountTo;
-        ss << " | Saldo origen: $" << accounts[t.accountFrom];
-        ss << " | Saldo destino: $" << accounts[t.accountTo];
+    // Estado de una cuenta antes de un lote atómico, para revertirlo
+    struct AccountSnapshot {
+        double balance;
+        VelocityCounters velocity;
+    };
 
-        std::cout << "[SUCCESS] " << ss.str() << std::endl;
-        return ss.str();
+    // Solo para revertir un lote atómico, con la cuenta tomada en exclusiva
+    static void restoreAccount(AccountRecord& account, const AccountSnapshot& snapshot) {
+        if (SplitBalance* split = account.splitBalance()) {
+            split->adjust(snapshot.balance - split->read());
+        } else {
+            account.balance = snapshot.balance;
+        }
+        account.velocity = snapshot.velocity;
     }
 
-    std::string processBalance(const Transaction& t) {
-        if (accounts.find(t.accountFrom) == accounts.end()) {
-            return "ERROR: Cuenta no existe";
+    // Requiere el lock del fragmento de la cuenta: la división se publica con el saldo
+    // actual y a partir de ahí ninguna operación vuelve a usar `balance`
+    void maybeSplit(const std::string& accountId) {
+        auto it = accounts.find(accountId);
+        if (it == accounts.end() || it->second.splitBalance() || it->second.creditsInWindow < splitThreshold) {
+            return;
         }
+        AccountRecord& account = it->second;
+        account.split.store(new SplitBalance(account.balance, splitStripes), std::memory_order_release);
+        splitAccounts++;
+        std::cout << "[INFO] Cuenta " << accountId << " dividida en " << splitStripes << " franjas ("
+                  << account.creditsInWindow << " créditos en el último segundo)" << std::endl;
+    }
 
-        std::stringstream ss;
-        ss << "BALANCE SUCCESS - Cuenta " << t.accountFrom << ": $" << accounts[t.accountFrom];
-        
-        std::cout << "[SUCCESS] " << ss.str() << std::endl;
-        return ss.str();
+    // Toma los locks de los fragmentos indicados en orden ascendente para evitar deadlocks
+    std::vector<std::unique_lock<std::mutex>> lockShards(std::vector<size_t> shards) {
+        std::sort(shards.begin(), shards.end());
+        shards.erase(std::unique(shards.begin(), shards.end()), shards.end());
+
+        std::vector<std::unique_lock<std::mutex>> locks;
+        locks.reserve(shards.size());
+        for (size_t shard : shards) {
+            locks.emplace_back(accountShardMutexes[shard]);
+        }
+        return locks;
+    }
+
+    void recordExecution(const Transaction& t) {
+        std::cout << "[INFO] Ejecutando transacción tipo: " << transactionTypeName(t.type) << std::endl;
+        std::cout << "[INFO] ID Transacción: " << t.id << std::endl;
+        std::cout << "[INFO] Monto: $" << t.amount << std::endl;
+
+        processedTransactions++;
+        throughput.record();
+        hotAccounts.touch(t.accountFrom);
+        hotAccounts.touch(t.accountTo);
+    }
+
+    static ExecutionOutcome failure(const char* error) {
+        ExecutionOutcome outcome;
+        outcome.error = error;
+        return outcome;
     }
 
-    std::string processPayment(const Transaction& t) {
-        if (accounts.find(t.accountFrom) == accounts.end()) {
-            return "ERROR: Cuenta no existe";
+    static void countResult(TransactionType type, const ExecutionOutcome& outcome) {
+        Metrics::countTransaction(handlerOf(type).metric, outcome.ok());
+        if (!outcome.ok()) {
+            Metrics::countError(Metrics::ErrorReason::ExecutionRejected);
         }
-        if (accounts[t.accountFrom] < t.amount) {
-            return "ERROR: Saldo insuficiente";
+    }
+
+    // Texto del resultado a partir de los saldos capturados durante la ejecución
+    void formatResult(const Transaction& t, const ExecutionOutcome& outcome, ResponseWriter& writer) {
+        if (!outcome.ok()) {
+            writer << std::string_view(outcome.error);
+            return;
+        }
+        switch (t.type) {
+        case TransactionType::Transfer:
+            writer << "TRANSFER SUCCESS - $" << t.amount << " transferidos de " << t.accountFrom
+                   << " a " << t.accountTo << " | Saldo origen: $" << outcome.balanceFrom
+                   << " | Saldo destino: " << (outcome.balanceToApproximate ? "~$" : "$") << outcome.balanceTo;
+            break;
+        case TransactionType::Balance:
+            writer << "BALANCE SUCCESS - Cuenta " << t.accountFrom << ": $" << outcome.balanceFrom;
+            break;
+        case TransactionType::Payment:
+            writer << "PAYMENT SUCCESS - $" << t.amount << " pagados a servicio " << t.serviceCode
+                   << " desde cuenta " << t.accountFrom << " | Saldo restante: $" << outcome.balanceFrom;
+            break;
+        case TransactionType::Deposit:
+            writer << "DEPOSIT SUCCESS - $" << t.amount << " depositados en cuenta " << t.accountTo
+                   << " | Saldo actual: " << (outcome.balanceToApproximate ? "~$" : "$") << outcome.balanceTo;
+            break;
+        case TransactionType::Unknown:
+            break;
+        }
+    }
+
+    // Formato del lote descifrado:
+    //   BATCH|<id_lote>|<timestamp>|<ATOMIC|PARTIAL>|<cantidad>|<token>
+    //   <transacción serializada>\n ... (una por línea)
+    void processBatch(const std::string& data, std::string& out, bool sessionAuthenticated) {
+        std::vector<std::string> lines;
+        std::stringstream ss(data);
+        std::string line;
+        while (std::getline(ss, line, '\n')) {
+            if (!line.empty()) {
+                lines.push_back(line);
+            }
         }
 
-        accounts[t.accountFrom] -= t.amount;
+        std::vector<std::string> header;
+        std::stringstream hs(lines.empty() ? std::string() : lines[0]);
+        std::string field;
+        while (std::getline(hs, field, '|')) {
+            header.push_back(field);
+        }
 
-        std::stringstream ss;
-        ss << "PAYMENT SUCCESS - $" << t.amount << " pagados a servicio " << t.serviceCode;
-        ss << " desde cuenta " << t.accountFrom;
-        ss << " | Saldo restante: $" << accounts[t.accountFrom];
+        if (header.size() < 6) {
+            std::cout << "[ERROR] Encabezado de lote incompleto. Partes: " << header.size() << std::endl;
+            Metrics::countError(Metrics::ErrorReason::InvalidFormat);
+            writeErrorResponse(out, "Formato de lote inválido");
+            return;
+        }
 
-        std::cout << "[SUCCESS] " << ss.str() << std::endl;
-        return ss.str();
+        const std::string& batchId = header[1];
+        const std::string& mode = header[3];
+        const std::string& token = header[5];
+        bool atomic = (mode == "ATOMIC");
+        if (!atomic && mode != "PARTIAL") {
+            writeErrorResponse(out, "Modo de lote no soportado");
+            return;
+        }
+        // Revertir un lote atómico requeriría coordinar varias particiones a la vez
+        if (atomic && ledger) {
+            writeErrorResponse(out, "Lotes atómicos no disponibles con el ledger por particiones");
+            return;
+        }
+
+        size_t declaredCount = 0;
+        try {
+            declaredCount = std::stoul(header[4]);
+        } catch (const std::exception&) {
+            writeErrorResponse(out, "Formato de lote inválido");
+            return;
+        }
+        if (declaredCount != lines.size() - 1) {
+            std::cout << "[ERROR] Lote declara " << declaredCount << " transacciones, recibidas "
+                      << lines.size() - 1 << std::endl;
+            writeErrorResponse(out, "Cantidad de transacciones del lote no coincide");
+            return;
+        }
+        if (declaredCount == 0 || declaredCount > MAX_BATCH_ITEMS) {
+            writeErrorResponse(out, "Tamaño de lote inválido");
+            return;
+        }
+
+        // Un único token autentica todo el lote (no hace falta dentro de una sesión)
+        if (!sessionAuthenticated) {
+            StageTimer tokenTimer(Metrics::Stage::TokenValidation);
+            if (!CryptoUtils::validateDynamicToken(token, secretKey, batchId)) {
+                std::cout << "[ERROR] Token dinámico del lote inválido o expirado" << std::endl;
+                Metrics::countError(Metrics::ErrorReason::InvalidToken);
+                writeErrorResponse(out, "Token dinámico inválido");
+                return;
+            }
+            tokenTimer.stop();
+        }
+
+        StageTimer parseTimer(Metrics::Stage::Parse);
+        std::vector<Transaction> items;
+        items.reserve(declaredCount);
+        std::vector<size_t> shards;
+        for (size_t i = 1; i < lines.size(); i++) {
+            items.push_back(parseTransaction(lines[i]));
+            if (!items.back().scheduledAt.empty()) {
+                writeErrorResponse(out, "Las transacciones programadas no se admiten en lotes");
+                return;
+            }
+            std::vector<size_t> itemShards = shardsOf(items.back());
+            shards.insert(shards.end(), itemShards.begin(), itemShards.end());
+        }
+        parseTimer.stop();
+
+        // Cada cuenta del lote consume un único permiso del limitador, sin importar cuántas transacciones tenga
+        std::vector<std::string> batchAccounts;
+        for (const Transaction& t : items) {
+            batchAccounts.push_back(rateLimitKey(t));
+        }
+        std::sort(batchAccounts.begin(), batchAccounts.end());
+        batchAccounts.erase(std::unique(batchAccounts.begin(), batchAccounts.end()), batchAccounts.end());
+        for (size_t i = 0; i < batchAccounts.size(); i++) {
+            const std::string& account = batchAccounts[i];
+            if (!accountLimiter.allow(account)) {
+                // El lote no se ejecuta: las cuentas anteriores recuperan su permiso
+                for (size_t j = 0; j < i; j++) {
+                    accountLimiter.refund(batchAccounts[j]);
+                }
+                Metrics::countError(Metrics::ErrorReason::RateLimited);
+                std::cout << "[WARNING] Límite de tasa excedido para la cuenta " << account << std::endl;
+                writeErrorResponse(out, "Límite de tasa excedido por cuenta", "RATE_LIMITED");
+                return;
+            }
+        }
+
+        std::cout << "[INFO] Ejecutando lote " << batchId << " (" << mode << ") con "
+                  << items.size() << " transacciones" << std::endl;
+
+        size_t applied = 0;
+        std::vector<std::pair<size_t, const char*>> failures;
+        StageTimer executeTimer(Metrics::Stage::Execute);
+        {
+            // Los locks de todos los fragmentos involucrados se toman una sola vez por lote;
+            // con el ledger por particiones no hay locks y cada transacción va a su partición
+            auto locks = ledger ? std::vector<std::unique_lock<std::mutex>>() : lockShards(shards);
+
+            // Un lote atómico también toma en exclusiva las cuentas divididas (en orden de
+            // cuenta, después de los fragmentos), para que nadie vea ni gaste sus créditos
+            // antes de saber si el lote se revierte. Se consulta con los fragmentos ya
+            // tomados: una cuenta de estos fragmentos ya no puede dividirse a mitad del lote.
+            std::vector<std::unique_ptr<SplitBalance::Exclusive>> exclusive;
+            if (atomic) {
+                std::map<std::string, SplitBalance*> splitInBatch;
+                for (const Transaction& t : items) {
+                    for (const std::string* account : {&t.accountFrom, &t.accountTo}) {
+                        auto it = accounts.find(*account);
+                        if (it != accounts.end() && it->second.splitBalance()) {
+                            splitInBatch.emplace(it->first, it->second.splitBalance());
+                        }
+                    }
+                }
+                for (const auto& entry : splitInBatch) {
+                    exclusive.emplace_back(new SplitBalance::Exclusive(*entry.second));
+                }
+            }
+
+            // Saldos y contadores previos de las cuentas tocadas, para revertir un lote atómico
+            std::map<std::string, AccountSnapshot> undo;
+
+            for (size_t i = 0; i < items.size(); i++) {
+                const Transaction& t = items[i];
+                if (atomic) {
+                    for (const std::string* account : {&t.accountFrom, &t.accountTo}) {
+                        auto it = accounts.find(*account);
+                        if (it != accounts.end() && undo.find(it->first) == undo.end()) {
+                            undo.emplace(it->first, AccountSnapshot{balanceOf(it->second), it->second.velocity});
+                        }
+                    }
+                }
+
+                ExecutionOutcome outcome = ledger ? executeTransaction(t) : dispatchTransaction(t);
+                countResult(t.type, outcome);
+                if (outcome.ok()) {
+                    applied++;
+                    continue;
+                }
+
+                if (atomic) {
+                    for (const auto& entry : undo) {
+                        restoreAccount(accounts.find(entry.first)->second, entry.second);
+                    }
+                    exclusive.clear();
+                    locks.clear();
+                    recordHistory(items, i + 1);
+                    std::cout << "[ERROR] Lote " << batchId << " revertido en la transacción " << i + 1
+                              << ": " << outcome.error << std::endl;
+                    Metrics::countTransaction(Metrics::TxType::Batch, false);
+                    char buffer[CryptoUtils::TIMESTAMP_LENGTH];
+                    ResponseWriter writer(out);
+                    writer << "ERROR|" << timestamp(buffer) << "|Lote revertido - transacción "
+                           << static_cast<uint64_t>(i + 1) << " (" << t.id << "): " << std::string_view(outcome.error);
+                    return;
+                }
+
+                failures.emplace_back(i + 1, outcome.error);
+            }
+        }
+        executeTimer.stop();
+        Metrics::countTransaction(Metrics::TxType::Batch, true);
+
+        recordHistory(items, items.size());
+
+        ResponseWriter writer(out);
+        writeSuccessHeader(writer, batchId);
+        size_t resultStart = writer.size();
+        writer << "BATCH " << mode << " SUCCESS - " << static_cast<uint64_t>(applied) << '/'
+               << static_cast<uint64_t>(items.size()) << " transacciones aplicadas";
+        for (size_t i = 0; i < failures.size(); i++) {
+            writer << (i == 0 ? " - Fallidas: " : "; ") << static_cast<uint64_t>(failures[i].first) << '='
+                   << std::string_view(failures[i].second);
+        }
+
+        std::cout << "[SUCCESS] " << std::string_view(out).substr(resultStart) << std::endl;
     }
 
-    std::string processDeposit(const Transaction& t) {
-        if (accounts.find(t.accountTo) == accounts.end()) {
-            return "ERROR: Cuenta destino no existe";
+    // Como en una transacción suelta, el historial guarda todas las que llegaron a
+    // ejecutarse, fallaran o no (en un lote atómico revertido, hasta la que falló)
+    void recordHistory(const std::vector<Transaction>& items, size_t count) {
+        std::vector<TransactionRecord> records;
+        records.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            records.push_back(TransactionRecord::pack(items[i], historyStrings));
+        }
+        {
+            std::lock_guard<std::mutex> lock(historyMutex);
+            transactionHistory.insert(transactionHistory.end(), records.begin(), records.end());
         }
+        historySize += count;
+    }
 
-        accounts[t.accountTo] += t.amount;
+    ExecutionOutcome processTransfer(const Transaction& t) {
+        auto from = accounts.find(t.accountFrom);
+        if (from == accounts.end()) {
+            return failure("ERROR: Cuenta origen no existe");
+        }
+        auto to = accounts.find(t.accountTo);
+        if (to == accounts.end()) {
+            return failure("ERROR: Cuenta destino no existe");
+        }
 
-        std::stringstream ss;
-        ss << "DEPOSIT SUCCESS - $" << t.amount << " depositados en cuenta " << t.accountTo;
-        ss << " | Saldo actual: $" << accounts[t.accountTo];
+        ExecutionOutcome outcome;
+        if (const char* error = debit(from->second, t.amount, outcome.balanceFrom)) {
+            return failure(error);
+        }
+        outcome.balanceTo = credit(to->second, t.amount, outcome.balanceToApproximate);
+        if (from == to) {
+            outcome.balanceFrom = outcome.balanceTo;
+        }
+        return outcome;
+    }
 
-        std::cout << "[SUCCESS] " << ss.str() << std::endl;
-        return ss.str();
+    ExecutionOutcome processBalance(const Transaction& t) {
+        auto account = accounts.find(t.accountFrom);
+        if (account == accounts.end()) {
+            return failure("ERROR: Cuenta no existe");
+        }
+
+        ExecutionOutcome outcome;
+        outcome.balanceFrom = balanceOf(account->second);
+        return outcome;
     }
 
-    std::string createSuccessResponse(const std::string& result, const std::string& transactionId) {
-        std::stringstream ss;
-        ss << "SUCCESS|" << CryptoUtils::getCurrentTimestamp() << "|" << transactionId << "|" << result;
-        return ss.str();
+    ExecutionOutcome processPayment(const Transaction& t) {
+        auto account = accounts.find(t.accountFrom);
+        if (account == accounts.end()) {
+            return failure("ERROR: Cuenta no existe");
+        }
+
+        ExecutionOutcome outcome;
+        if (const char* error = debit(account->second, t.amount, outcome.balanceFrom)) {
+            return failure(error);
+        }
+        return outcome;
     }
 
-    std::string createErrorResponse(const std::string& error) {
+    ExecutionOutcome processDeposit(const Transaction& t) {
+        auto account = accounts.find(t.accountTo);
+        if (account == accounts.end()) {
+            return failure("ERROR: Cuenta destino no existe");
+        }
+
+        ExecutionOutcome outcome;
+        outcome.balanceTo = credit(account->second, t.amount, outcome.balanceToApproximate);
+        return outcome;
+    }
+
+    static std::string_view timestamp(char (&buffer)[CryptoUtils::TIMESTAMP_LENGTH]) {
+        return std::string_view(buffer, CryptoUtils::formatTimestamp(buffer));
+    }
+
+    void writeSuccessHeader(ResponseWriter& writer, const std::string& transactionId) {
+        char buffer[CryptoUtils::TIMESTAMP_LENGTH];
+        writer << "SUCCESS|" << timestamp(buffer) << '|' << transactionId << '|';
+    }
+
+    // `code` agrega un sufijo legible por máquina (BUSY, RATE_LIMITED) para reintentos
+    void writeErrorResponse(std::string& out, std::string_view error, std::string_view code = std::string_view()) {
+        char buffer[CryptoUtils::TIMESTAMP_LENGTH];
+        ResponseWriter writer(out);
+        writer << "ERROR|" << timestamp(buffer) << '|' << error;
+        if (!code.empty()) {
+            writer << '|' << code;
+        }
+    }
+
+    // La cuenta que origina el movimiento; en depósitos, la cuenta destino
+    static const std::string& rateLimitKey(const Transaction& t) {
+        return t.accountFrom.empty() ? t.accountTo : t.accountFrom;
+    }
+
+    // POST /ratelimit?ip_rps=..&ip_burst=..&account_rps=..&account_burst=.. cambia los límites en
+    // caliente; sin parámetros solo muestra los valores actuales
+    std::string configureRateLimits(const std::string& path) {
+        double ipRate = ipLimiter.rate(), ipBurst = ipLimiter.burstSize();
+        double accountRate = accountLimiter.rate(), accountBurst = accountLimiter.burstSize();
+
+        size_t query = path.find('?');
+        if (query != std::string::npos) {
+            std::stringstream params(path.substr(query + 1));
+            std::string param;
+            while (std::getline(params, param, '&')) {
+                size_t eq = param.find('=');
+                if (eq == std::string::npos) {
+                    continue;
+                }
+                std::string name = param.substr(0, eq);
+                double value = std::atof(param.c_str() + eq + 1);
+                if (name == "ip_rps") ipRate = value;
+                else if (name == "ip_burst") ipBurst = value;
+                else if (name == "account_rps") accountRate = value;
+                else if (name == "account_burst") accountBurst = value;
+            }
+            ipLimiter.configure(ipRate, ipBurst);
+            accountLimiter.configure(accountRate, accountBurst);
+            std::cout << "[INFO] Límites de tasa actualizados: IP " << ipRate << "/s (ráfaga " << ipBurst
+                      << "), cuenta " << accountRate << "/s (ráfaga " << accountBurst << ")" << std::endl;
+        }
+
         std::stringstream ss;
-        ss << "ERROR|" << CryptoUtils::getCurrentTimestamp() << "|" << error;
+        ss << "ip_rps=" << ipLimiter.rate() << "\n";
+        ss << "ip_burst=" << ipLimiter.burstSize() << "\n";
+        ss << "account_rps=" << accountLimiter.rate() << "\n";
+        ss << "account_burst=" << accountLimiter.burstSize() << "\n";
         return ss.str();
     }
 
+    ~TransactionServer() {
+        stopWorkers();
+        if (ledger) {
+            ledger->stop();
+        }
+    }
+
     void stop() {
         running = false;
+        scheduler->stop();
+        reaper->stop();
         if (serverSocket >= 0) {
             close(serverSocket);
+            serverSocket = -1;
+        }
+        // Los mensajes ya encolados se procesan antes de que terminen los trabajadores
+        stopWorkers();
+        // Los endpoints HTTP consultan el ledger (/status, /ledger/audit): se detienen antes
+        if (metricsEndpoint) {
+            metricsEndpoint->stop();
+        }
+        if (adminEndpoint) {
+            adminEndpoint->stop();
         }
-        std::cout << "[INFO] Servidor detenido" << std::endl;
+        if (ledger) {
+            ledger->stop();
+        }
+        std::cout << "[INFO] Servidor detenido (" << processedTransactions.load() << " transacciones procesadas, "
+                  << historySize.load() << " en el historial)" << std::endl;
     }
 
-    void printStatus() {
-        std::cout << "\n=== ESTADO DEL SERVIDOR ===" << std::endl;
-        std::cout << "Puerto: " << port << std::endl;
-        std::cout << "Estado: " << (running ? "EJECUTÁNDOSE" : "DETENIDO") << std::endl;
-        
-        {
-            std::lock_guard<std::mutex> lock(accountsMutex);
-            std::cout << "\n--- CUENTAS ---" << std::endl;
-            for (const auto& account : accounts) {
-                std::cout << "Cuenta: " << account.first << " - Saldo: $" << account.second << std::endl;
+    // Vista del estado para el puerto de administración. Solo lee contadores atómicos,
+    // el muestreo de cuentas activas y, por cada cuenta mostrada, el lock de su fragmento.
+    std::string renderStatus() {
+        auto uptime = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+
+        std::stringstream ss;
+        ss << "=== ESTADO DEL SERVIDOR ===\n";
+        ss << "Puerto: " << port << "\n";
+        ss << "Estado: " << (draining ? "DRENANDO" : running ? "EJECUTÁNDOSE" : "DETENIDO") << "\n";
+        ss << "Tiempo activo: " << uptime << " s\n";
+
+        ss << "\n--- CONEXIONES ---\n";
+        ss << "Activas: " << activeConnections.load() << " / " << maxConnections << "\n";
+        ss << "Aceptadas: " << acceptedConnections.load() << "\n";
+        ss << "Rechazadas por límite: " << rejectedConnections.load() << "\n";
+        ss << "Sesiones establecidas: " << sessionsEstablished.load() << "\n";
+        ss << reaper->describe();
+
+        ss << "\n--- COLA DE TRABAJO ---\n";
+        ss << "Profundidad: " << workQueue->size() << " / " << workQueue->maxSize() << "\n";
+        ss << "Hilos trabajadores: " << workers.size() << "\n";
+        ss << "Mensajes rechazados (BUSY): " << shedRequests.load() << "\n";
+        ss << "Lotes criptográficos: " << cryptoBatches.load() << " (" << cryptoBatchedMessages.load()
+           << " mensajes, hasta " << cryptoBatchSize << " por lote desde profundidad " << cryptoBatchDepth << ")\n";
+
+        ss << "\n--- LÍMITES DE TASA ---\n";
+        ss << "Por IP: ";
+        if (ipLimiter.rate() > 0) {
+            ss << ipLimiter.rate() << " msg/s, ráfaga " << ipLimiter.burstSize();
+        } else {
+            ss << "desactivado";
+        }
+        ss << " - rechazados: " << ipLimiter.rejected() << "\n";
+        ss << "Por cuenta: ";
+        if (accountLimiter.rate() > 0) {
+            ss << accountLimiter.rate() << " tx/s, ráfaga " << accountLimiter.burstSize();
+        } else {
+            ss << "desactivado";
+        }
+        ss << " - rechazados: " << accountLimiter.rejected() << "\n";
+
+        ss << "\n--- THROUGHPUT ---\n";
+        ss << "Transacciones ejecutadas: " << processedTransactions.load() << "\n";
+        ss << "Últimos 10 s: " << throughput.ratePerSecond(10) << " tx/s\n";
+        ss << "Últimos 59 s: " << throughput.ratePerSecond(59) << " tx/s\n";
+
+        ss << "\n--- CUENTAS MÁS ACTIVAS (muestreo 1/" << HotAccountSampler::SAMPLE_RATE << ") ---\n";
+        ss << "Cuentas registradas: " << accounts.size() << "\n";
+        if (splitThreshold > 0) {
+            ss << "Cuentas divididas: " << splitAccounts.load() << " (umbral " << splitThreshold
+               << " créditos/s, " << splitStripes << " franjas)\n";
+        }
+        for (const auto& hot : hotAccounts.top(5)) {
+            auto account = accounts.find(hot.first);
+            if (account == accounts.end()) {
+                continue;
             }
+            double balance;
+            if (ledger) {
+                if (!ledger->balance(hot.first, balance)) {
+                    continue;
+                }
+            } else if (account->second.splitBalance()) {
+                balance = account->second.splitBalance()->read();
+            } else {
+                std::lock_guard<std::mutex> lock(accountShardMutexes[shardOf(hot.first)]);
+                balance = account->second.balance;
+            }
+            ss << "Cuenta: " << hot.first << " - Muestras: " << hot.second << " - Saldo: $" << balance << "\n";
+        }
+
+        ss << "\n--- LÍMITES DE VELOCIDAD ---\n";
+        ss << velocityLimits.describe() << "\n";
+        if (velocityLimits.enabled()) {
+            ss << "Débitos rechazados: "
+               << (ledger ? ledger->velocityRejections() : velocityRejections.load()) << "\n";
+        }
+
+        ss << "\n--- TRANSACCIONES PROGRAMADAS ---\n";
+        ss << scheduler->describe();
+
+        ss << "\n--- CATÁLOGO DE SERVICIOS ---\n";
+        ss << services.describe() << "\n";
+
+        if (ledger) {
+            ss << "\n--- LEDGER POR PARTICIONES ---\n";
+            ss << ledger->describe();
         }
 
+        ss << "\n--- HISTORIAL DE TRANSACCIONES ---\n";
+        ss << "Total de transacciones: " << historySize.load() << "\n";
+
+        // Últimas 5 transacciones: se copian bajo el lock y se formatean fuera de él
+        std::vector<TransactionRecord> recent;
+        size_t historyBytes;
         {
             std::lock_guard<std::mutex> lock(historyMutex);
-            std::cout << "\n--- HISTORIAL DE TRANSACCIONES ---" << std::endl;
-            std::cout << "Total de transacciones: " << transactionHistory.size() << std::endl;
-            
-            // Mostrar las últimas 5 transacciones
-            int count = 0;
-            for (auto it = transactionHistory.rbegin(); it != transactionHistory.rend() && count < 5; ++it, ++count) {
-                std::cout << "  " << it->timestamp << " - " << it->type << " - $" << it->amount << std::endl;
-            }
+            size_t count = std::min<size_t>(5, transactionHistory.size());
+            recent.assign(transactionHistory.end() - count, transactionHistory.end());
+            historyBytes = transactionHistory.capacity() * sizeof(TransactionRecord);
+        }
+        ss << "Memoria del historial: " << (historyBytes + historyStrings.memoryBytes()) / 1024 << " KB ("
+           << sizeof(TransactionRecord) << " bytes por registro, " << historyStrings.size()
+           << " cadenas internadas)\n";
+        for (auto it = recent.rbegin(); it != recent.rend(); ++it) {
+            Transaction t = it->unpack(historyStrings);
+            ss << "  " << t.timestamp << " - " << transactionTypeName(t.type) << " - $" << t.amount << "\n";
         }
-        std::cout << "==========================\n" << std::endl;
+        ss << "==========================\n";
+        return ss.str();
     }
 };
 
-// Variable global para manejo de señales
-TransactionServer* globalServer = nullptr;
+// Self-pipe para señales: el manejador solo escribe el número de señal y el hilo
+// principal lo recibe en su poll. La segunda señal termina sin esperar al drenaje.
+int signalPipe[2] = {-1, -1};
+std::atomic<bool> signalReceived{false};
+static_assert(std::atomic<bool>::is_always_lock_free, "el manejador de señales requiere un atómico sin locks");
 
 void signalHandler(int signal) {
-    std::cout << "\n[INFO] Señal recibida (" << signal << "). Cerrando servidor..." << std::endl;
-    if (globalServer) {
-        globalServer->stop();
+    if (signalReceived.exchange(true)) {
+        _exit(1);
     }
-    exit(0);
+    int savedErrno = errno;
+    ssize_t written = write(signalPipe[1], &signal, sizeof(signal));
+    (void)written;
+    errno = savedErrno;
 }
 
 int main(int argc, char* argv[]) {
@@ -421,11 +1916,19 @@ int main(int argc, char* argv[]) {
     }
 
     TransactionServer server(port);
-    globalServer = &server;
 
     // Configurar manejo de señales
-    signal(SIGINT, signalHandler);
-    signal(SIGTERM, signalHandler);
+    if (pipe2(signalPipe, O_CLOEXEC | O_NONBLOCK) < 0) {
+        std::cerr << "[ERROR] No se pudo crear el pipe de señales" << std::endl;
+        return 1;
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = signalHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
 
     if (!server.start()) {
         std::cerr << "[ERROR] No se pudo iniciar el servidor" << std::endl;
@@ -436,7 +1939,7 @@ int main(int argc, char* argv[]) {
     std::cout << "[INFO] Para interactuar con el servidor, use el cliente desde otro contenedor." << std::endl;
 
     // Ejecutar servidor sin hilo de consola para Docker
-    server.run();
+    server.run(signalPipe[0]);
 
     return 0;
 }
\ No newline at end of file
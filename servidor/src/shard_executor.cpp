@@ -0,0 +1,499 @@
+#include "shard_executor.h"
+#include <iostream>
+#include <sstream>
+#include <chrono>
+
+namespace {
+// Iteraciones sin trabajo antes de que un hilo se duerma
+const int SPIN_LIMIT = 256;
+}
+
+void LedgerCompletion::wait() {
+    for (int i = 0; i < SPIN_LIMIT; i++) {
+        if (state.load(std::memory_order_acquire) == DONE) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    int expected = PENDING;
+    if (state.compare_exchange_strong(expected, PARKED, std::memory_order_acq_rel)) {
+        ready.wait(lock, [this] { return state.load(std::memory_order_acquire) == DONE; });
+    }
+}
+
+void LedgerCompletion::signal() {
+    // Si nadie duerme, marcar como terminado es el último acceso al objeto
+    int expected = PENDING;
+    if (state.compare_exchange_strong(expected, DONE, std::memory_order_acq_rel)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    state.store(DONE, std::memory_order_release);
+    ready.notify_one();
+}
+
+ShardExecutor::ShardExecutor(size_t partitionCount, const AccountTable& accounts,
+                             size_t queueCapacity, const VelocityLimits& velocityLimits)
+    : velocityLimits(velocityLimits), running(false) {
+    if (partitionCount == 0) {
+        partitionCount = 1;
+    }
+    for (size_t i = 0; i < partitionCount; i++) {
+        partitions.emplace_back(new Partition(queueCapacity));
+    }
+
+    // Reparto estable por hash: la misma cuenta cae siempre en la misma partición
+    directory.reserve(accounts.size());
+    for (const auto& account : accounts) {
+        uint32_t index = static_cast<uint32_t>(std::hash<std::string>{}(account.first) % partitionCount);
+        Partition& partition = *partitions[index];
+        uint32_t slot = static_cast<uint32_t>(partition.balances.size());
+        partition.names.push_back(account.first);
+        partition.balances.push_back(account.second.balance);
+        partition.checkpointBalances.push_back(account.second.balance);
+        directory.emplace(account.first, Location{index, slot});
+    }
+    for (auto& partition : partitions) {
+        partition->journal.reserve(JOURNAL_CHECKPOINT);
+    }
+    if (velocityLimits.enabled()) {
+        for (auto& partition : partitions) {
+            partition->velocity.resize(partition->balances.size());
+        }
+    }
+}
+
+ShardExecutor::~ShardExecutor() {
+    stop();
+}
+
+void ShardExecutor::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    for (size_t i = 0; i < partitions.size(); i++) {
+        partitions[i]->thread = std::thread(&ShardExecutor::run, this, i);
+    }
+    std::cout << "[INFO] Ledger por particiones: " << partitions.size() << " particiones, "
+              << directory.size() << " cuentas, cola de " << partitions[0]->inbox.capacity()
+              << " comandos por partición" << std::endl;
+}
+
+void ShardExecutor::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    for (auto& partition : partitions) {
+        wake(*partition);
+    }
+    for (auto& partition : partitions) {
+        if (partition->thread.joinable()) {
+            partition->thread.join();
+        }
+    }
+}
+
+const ShardExecutor::Location* ShardExecutor::locate(const std::string& account) const {
+    auto it = directory.find(account);
+    return it == directory.end() ? nullptr : &it->second;
+}
+
+ExecutionOutcome ShardExecutor::execute(const Transaction& t) {
+    Command command;
+    command.transaction = &t;
+    command.amount = t.amount;
+
+    const Location* owner = nullptr;
+    switch (t.type) {
+    case TransactionType::Transfer: {
+        owner = locate(t.accountFrom);
+        if (!owner) {
+            return ExecutionOutcome{"ERROR: Cuenta origen no existe"};
+        }
+        const Location* target = locate(t.accountTo);
+        if (!target) {
+            return ExecutionOutcome{"ERROR: Cuenta destino no existe"};
+        }
+        command.operation = Operation::Transfer;
+        command.target = *target;
+        break;
+    }
+    case TransactionType::Balance:
+    case TransactionType::Payment:
+        owner = locate(t.accountFrom);
+        if (!owner) {
+            return ExecutionOutcome{"ERROR: Cuenta no existe"};
+        }
+        command.operation = t.type == TransactionType::Balance ? Operation::Read : Operation::Payment;
+        break;
+    case TransactionType::Deposit:
+        owner = locate(t.accountTo);
+        if (!owner) {
+            return ExecutionOutcome{"ERROR: Cuenta destino no existe"};
+        }
+        command.operation = Operation::Deposit;
+        break;
+    default:
+        return ExecutionOutcome{"ERROR: Tipo de transacción no soportado"};
+    }
+
+    command.slot = owner->slot;
+    return submit(owner->partition, command);
+}
+
+bool ShardExecutor::balance(const std::string& account, double& out) {
+    const Location* owner = locate(account);
+    if (!owner) {
+        return false;
+    }
+    Command command;
+    command.operation = Operation::Read;
+    command.slot = owner->slot;
+    ExecutionOutcome outcome = submit(owner->partition, command);
+    if (!outcome.ok()) {
+        return false;
+    }
+    out = outcome.balanceFrom;
+    return true;
+}
+
+// Registrarse antes de mirar `running` (ambos seq_cst): o stop() ya lo apagó y no se
+// encola nada, o las particiones ven al llamador y no terminan sin atenderlo
+bool ShardExecutor::enter() {
+    submitters.fetch_add(1);
+    if (!running.load()) {
+        leave();
+        return false;
+    }
+    return true;
+}
+
+void ShardExecutor::leave() {
+    submitters.fetch_sub(1);
+}
+
+ExecutionOutcome ShardExecutor::submit(size_t partition, Command& command) {
+    if (!enter()) {
+        return ExecutionOutcome{"ERROR: Ledger detenido"};
+    }
+    LedgerCompletion completion;
+    command.completion = &completion;
+    post(*partitions[partition], command);
+    completion.wait();
+    leave();
+    return completion.outcome;
+}
+
+std::string ShardExecutor::audit() {
+    if (!enter()) {
+        return "Ledger detenido\n";
+    }
+    std::vector<std::string> reports(partitions.size());
+    std::vector<std::unique_ptr<LedgerCompletion>> completions;
+    for (size_t i = 0; i < partitions.size(); i++) {
+        completions.emplace_back(new LedgerCompletion());
+        Command command;
+        command.operation = Operation::Audit;
+        command.completion = completions.back().get();
+        command.report = &reports[i];
+        post(*partitions[i], command);
+    }
+
+    std::string report = "=== AUDITORÍA DEL LEDGER ===\n";
+    for (size_t i = 0; i < partitions.size(); i++) {
+        completions[i]->wait();
+        report += reports[i];
+    }
+    leave();
+    return report;
+}
+
+std::string ShardExecutor::describe() const {
+    std::stringstream ss;
+    for (size_t i = 0; i < partitions.size(); i++) {
+        const Partition& partition = *partitions[i];
+        ss << "Partición " << i << ": " << partition.names.size() << " cuentas, cola "
+           << partition.inbox.size() << " / " << partition.inbox.capacity()
+           << ", comandos " << partition.executed.load(std::memory_order_relaxed)
+           << ", créditos reenviados " << partition.forwarded.load(std::memory_order_relaxed)
+           << ", asientos " << partition.recorded.load(std::memory_order_relaxed)
+           << ", puntos de control " << partition.checkpoints.load(std::memory_order_relaxed) << "\n";
+    }
+    return ss.str();
+}
+
+// Productores: trabajadores y otras particiones. Si la cola está llena se espera
+// cediendo el procesador; la partición dueña la vacía sin depender del productor.
+void ShardExecutor::post(Partition& partition, const Command& command) {
+    while (!partition.inbox.tryPush(command)) {
+        std::this_thread::yield();
+    }
+    wake(partition);
+}
+
+void ShardExecutor::wake(Partition& partition) {
+    // Pareja de la barrera en run(): o el productor ve `sleeping`, o la partición ve el comando
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (partition.sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(partition.mutex);
+        partition.wakeup.notify_one();
+    }
+}
+
+void ShardExecutor::run(size_t index) {
+    Partition& partition = *partitions[index];
+    int idle = 0;
+    while (true) {
+        Command command;
+        if (partition.inbox.tryPop(command)) {
+            handle(partition, index, command);
+            idle = 0;
+            continue;
+        }
+        if (!partition.outbox.empty() && !flushOutbox(partition)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (!running.load()) {
+            // Un llamador en espera puede tener un comando (o un crédito reenviado)
+            // todavía en camino hacia esta partición
+            if (submitters.load() == 0) {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        if (++idle < SPIN_LIMIT) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(partition.mutex);
+        partition.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        partition.wakeup.wait(lock, [&] {
+            return partition.inbox.readable() || !running.load(std::memory_order_acquire);
+        });
+        partition.sleeping.store(false, std::memory_order_relaxed);
+        idle = 0;
+    }
+    failPending(partition);
+}
+
+// Sin llamadores registrados no debería quedar nada; si quedara, se responde con
+// error en vez de dejar al que espera bloqueado para siempre
+void ShardExecutor::failPending(Partition& partition) {
+    Command command;
+    while (partition.inbox.tryPop(command)) {
+        command.completion->outcome.error = "ERROR: Ledger detenido";
+        if (command.report) {
+            *command.report = "Ledger detenido\n";
+        }
+        command.completion->signal();
+    }
+}
+
+void ShardExecutor::handle(Partition& partition, size_t index, const Command& command) {
+    partition.executed.fetch_add(1, std::memory_order_relaxed);
+    ExecutionOutcome& outcome = command.completion->outcome;
+
+    // `slot` solo es de esta partición en los comandos sobre la cuenta origen: un
+    // crédito reenviado trae el de la cuenta debitada y una auditoría no trae ninguno
+    switch (command.operation) {
+    case Operation::Transfer:
+        if (!debit(partition, command, outcome)) {
+            break;
+        }
+        if (command.target.partition != index) {
+            Command credit = command;
+            credit.operation = Operation::Credit;
+            forward(partition, credit);
+            return; // responde la partición destino
+        }
+        partition.balances[command.target.slot] += command.amount;
+        record(partition, 'C', command.target.slot, command.amount, command.transaction);
+        outcome.balanceTo = partition.balances[command.target.slot];
+        break;
+
+    case Operation::Credit: {
+        double& target = partition.balances[command.target.slot];
+        target += command.amount;
+        record(partition, 'C', command.target.slot, command.amount, command.transaction);
+        outcome.balanceTo = target;
+        break;
+    }
+
+    case Operation::Payment:
+        debit(partition, command, outcome);
+        break;
+
+    case Operation::Deposit: {
+        double& balance = partition.balances[command.slot];
+        balance += command.amount;
+        record(partition, 'C', command.slot, command.amount, command.transaction);
+        outcome.balanceTo = balance;
+        break;
+    }
+
+    case Operation::Read:
+        outcome.balanceFrom = partition.balances[command.slot];
+        break;
+
+    case Operation::Audit:
+        auditPartition(partition, index, *command.report);
+        break;
+    }
+    command.completion->signal();
+}
+
+// Los créditos hacia una partición salen en el orden en que se debitaron
+void ShardExecutor::forward(Partition& partition, const Command& command) {
+    partition.forwarded.fetch_add(1, std::memory_order_relaxed);
+    Partition& target = *partitions[command.target.partition];
+    if (partition.outbox.empty() && target.inbox.tryPush(command)) {
+        wake(target);
+        return;
+    }
+    // Nunca bloquear entre particiones: con dos colas llenas se produciría un deadlock
+    partition.outbox.push_back(command);
+}
+
+bool ShardExecutor::flushOutbox(Partition& partition) {
+    while (!partition.outbox.empty()) {
+        const Command& command = partition.outbox.front();
+        Partition& target = *partitions[command.target.partition];
+        if (!target.inbox.tryPush(command)) {
+            return false;
+        }
+        wake(target);
+        partition.outbox.pop_front();
+    }
+    return true;
+}
+
+// Débito en la partición dueña, con los límites de velocidad de la cuenta; solo este
+// hilo toca sus contadores
+bool ShardExecutor::debit(Partition& partition, const Command& command, ExecutionOutcome& outcome) {
+    double& balance = partition.balances[command.slot];
+    uint64_t now = 0;
+    if (!partition.velocity.empty()) {
+        now = VelocityCounters::nowMillis();
+        int window = partition.velocity[command.slot].exceeded(now, command.amount, velocityLimits);
+        if (window >= 0) {
+            partition.velocityRejected.fetch_add(1, std::memory_order_relaxed);
+            outcome.error = VelocityLimits::error(static_cast<size_t>(window));
+            return false;
+        }
+    }
+    if (balance < command.amount) {
+        outcome.error = "ERROR: Saldo insuficiente";
+        return false;
+    }
+    balance -= command.amount;
+    record(partition, 'D', command.slot, command.amount, command.transaction);
+    if (!partition.velocity.empty()) {
+        partition.velocity[command.slot].record(now, command.amount);
+    }
+    outcome.balanceFrom = balance;
+    return true;
+}
+
+uint64_t ShardExecutor::velocityRejections() const {
+    uint64_t total = 0;
+    for (const auto& partition : partitions) {
+        total += partition->velocityRejected.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void ShardExecutor::record(Partition& partition, char operation, uint32_t slot, double amount,
+                           const Transaction* t) {
+    TransactionIdRecord id{};
+    if (t) {
+        id = TransactionIdRecord::pack(t->id, partition.transactionIds);
+    }
+    partition.journal.push_back(JournalEntry{++partition.sequence, amount, partition.balances[slot], slot,
+                                             operation, id});
+    partition.recorded.store(partition.sequence, std::memory_order_relaxed);
+    if (partition.journal.size() >= JOURNAL_CHECKPOINT) {
+        checkpoint(partition);
+    }
+}
+
+// Verifica el tramo sobre los propios saldos del punto de control (solo toca las
+// cuentas con asientos) y lo descarta. Una diferencia se informa y queda guardada
+// para las auditorías siguientes.
+void ShardExecutor::checkpoint(Partition& partition) {
+    std::string difference;
+    bool consistent = replay(partition, partition.checkpointBalances, difference);
+    for (size_t i = 0; consistent && i < partition.journal.size(); i++) {
+        uint32_t slot = partition.journal[i].slot;
+        if (partition.checkpointBalances[slot] != partition.balances[slot]) {
+            std::stringstream ss;
+            ss << "DIFERENCIA en saldo de " << partition.names[slot] << ": actual $" << partition.balances[slot]
+               << ", reproducido $" << partition.checkpointBalances[slot] << "\n";
+            difference = ss.str();
+            consistent = false;
+        }
+    }
+    if (!consistent) {
+        std::cout << "[ERROR] Ledger: " << difference << std::flush;
+        if (partition.discrepancy.empty()) {
+            partition.discrepancy = difference;
+        }
+        partition.checkpointBalances = partition.balances;
+    }
+    partition.checkpointSequence = partition.sequence;
+    partition.journal.clear();
+    partition.transactionIds.clear();
+    partition.checkpoints.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Aplica el diario sobre `balances`; false con la primera diferencia en `difference`
+bool ShardExecutor::replay(const Partition& partition, std::vector<double>& balances, std::string& difference) const {
+    for (const JournalEntry& entry : partition.journal) {
+        double& balance = balances[entry.slot];
+        balance += entry.operation == 'D' ? -entry.amount : entry.amount;
+        if (balance != entry.balance) {
+            std::stringstream ss;
+            ss << "DIFERENCIA en asiento " << entry.sequence << " ("
+               << entry.transactionId.unpack(partition.transactionIds) << ", cuenta " << partition.names[entry.slot]
+               << "): diario $" << entry.balance << ", reproducido $" << balance << "\n";
+            difference = ss.str();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Se ejecuta en el hilo de la partición: ve el diario y los saldos sin carreras
+void ShardExecutor::auditPartition(const Partition& partition, size_t index, std::string& report) const {
+    std::stringstream ss;
+    ss << "Partición " << index << ": " << partition.journal.size() << " asientos desde el asiento "
+       << partition.checkpointSequence << " (" << partition.checkpoints.load(std::memory_order_relaxed)
+       << " puntos de control) - ";
+    if (!partition.discrepancy.empty()) {
+        ss << partition.discrepancy;
+        report = ss.str();
+        return;
+    }
+
+    std::vector<double> replayed = partition.checkpointBalances;
+    std::string difference;
+    if (!replay(partition, replayed, difference)) {
+        ss << difference;
+        report = ss.str();
+        return;
+    }
+    for (size_t slot = 0; slot < replayed.size(); slot++) {
+        if (replayed[slot] != partition.balances[slot]) {
+            ss << "DIFERENCIA en saldo final de " << partition.names[slot] << ": actual $"
+               << partition.balances[slot] << ", reproducido $" << replayed[slot] << "\n";
+            report = ss.str();
+            return;
+        }
+    }
+    ss << "OK\n";
+    report = ss.str();
+}
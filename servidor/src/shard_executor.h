@@ -0,0 +1,189 @@
+#ifndef SHARD_EXECUTOR_H
+#define SHARD_EXECUTOR_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include "crypto_utils.h"
+#include "mpsc_queue.h"
+#include "account_record.h"
+#include "velocity_counters.h"
+#include "transaction_record.h"
+
+// Resultado de ejecutar una transacción sobre el ledger; el texto de la respuesta
+// se arma después, fuera de los locks o de la partición que la ejecutó
+struct ExecutionOutcome {
+    const char* error = nullptr;
+    double balanceFrom = 0.0;
+    double balanceTo = 0.0;
+    // balanceTo es de una cuenta dividida: suma de sus franjas sin foto consistente
+    bool balanceToApproximate = false;
+
+    bool ok() const { return error == nullptr; }
+};
+
+// Espera de un hilo trabajador por el resultado de su transacción. Gira un poco
+// (la partición suele responder en microsegundos) y después se duerme. Quien señala
+// no toca el objeto después de marcarlo como terminado, así que puede vivir en la
+// pila del que espera.
+class LedgerCompletion {
+public:
+    LedgerCompletion() : state(PENDING) {}
+
+    LedgerCompletion(const LedgerCompletion&) = delete;
+    LedgerCompletion& operator=(const LedgerCompletion&) = delete;
+
+    void wait();
+    void signal();
+
+    ExecutionOutcome outcome;
+
+private:
+    static const int PENDING = 0;
+    static const int PARKED = 1;
+    static const int DONE = 2;
+
+    std::atomic<int> state;
+    std::mutex mutex;
+    std::condition_variable ready;
+};
+
+// Ledger particionado con un único escritor por partición. Cada cuenta pertenece a
+// una partición y solo el hilo de esa partición lee o modifica su saldo, así que no
+// hay locks sobre los saldos: los trabajadores encolan comandos en la cola sin locks
+// de la partición dueña y esperan el resultado.
+//
+// Una transferencia entre particiones se hace en dos pasos deterministas: la
+// partición de origen valida y debita, y envía el crédito a la partición destino,
+// que lo aplica y responde. Las cuentas se crean antes de arrancar y el directorio
+// cuenta -> partición es de solo lectura, así que la existencia de ambas cuentas se
+// valida antes de encolar y el crédito nunca falla.
+//
+// Cada partición registra sus movimientos en un diario ordenado; auditar reproduce
+// el diario desde los saldos del último punto de control y compara con los saldos
+// actuales. Cada JOURNAL_CHECKPOINT asientos la partición verifica el tramo, toma
+// esos saldos como punto de control y lo descarta: el diario no crece con el
+// historial y auditar cuesta a lo sumo un tramo más una pasada por los saldos.
+class ShardExecutor {
+public:
+    static const size_t JOURNAL_CHECKPOINT = 4096;
+
+    struct JournalEntry {
+        uint64_t sequence;
+        double amount;
+        double balance; // saldo de la cuenta después del movimiento
+        uint32_t slot;
+        char operation; // 'D' débito, 'C' crédito
+        TransactionIdRecord transactionId;
+    };
+
+    ShardExecutor(size_t partitionCount, const AccountTable& accounts, size_t queueCapacity,
+                  const VelocityLimits& velocityLimits = VelocityLimits());
+    ~ShardExecutor();
+
+    ShardExecutor(const ShardExecutor&) = delete;
+    ShardExecutor& operator=(const ShardExecutor&) = delete;
+
+    void start();
+    // Espera a los comandos en curso y detiene los hilos de las particiones; los
+    // llamados posteriores responden "Ledger detenido"
+    void stop();
+
+    // Ejecuta la transacción en la partición dueña; bloquea hasta tener el resultado.
+    // El monto ya viene validado por el llamador según la política del tipo.
+    ExecutionOutcome execute(const Transaction& t);
+    bool balance(const std::string& account, double& out);
+    // Reproduce el diario de cada partición y devuelve un informe legible
+    std::string audit();
+    // Profundidad de cola, comandos y asientos por partición
+    std::string describe() const;
+
+    size_t partitionCount() const { return partitions.size(); }
+    uint64_t velocityRejections() const;
+
+private:
+    enum class Operation : uint8_t {
+        Transfer, // débito en origen y crédito (local o reenviado) en destino
+        Payment,
+        Deposit,
+        Credit,   // segundo paso de una transferencia entre particiones
+        Read,
+        Audit
+    };
+
+    struct Location {
+        uint32_t partition;
+        uint32_t slot;
+    };
+
+    struct Command {
+        Operation operation = Operation::Read;
+        uint32_t slot = 0;
+        Location target{0, 0};
+        double amount = 0.0;
+        const Transaction* transaction = nullptr;
+        LedgerCompletion* completion = nullptr;
+        std::string* report = nullptr;
+    };
+
+    struct Partition {
+        explicit Partition(size_t capacity) : inbox(capacity) {}
+
+        MpscQueue<Command> inbox;
+        std::deque<Command> outbox; // créditos que no cupieron en la cola destino
+        std::vector<std::string> names;
+        std::vector<double> balances;
+        std::vector<double> checkpointBalances; // saldos en el último punto de control
+        std::vector<VelocityCounters> velocity; // solo con límites de velocidad activos
+        std::vector<JournalEntry> journal;      // asientos desde el último punto de control
+        StringPool transactionIds;              // IDs del tramo que no son UUID; se vacía con el diario
+        uint64_t sequence = 0;
+        uint64_t checkpointSequence = 0;        // último asiento incluido en el punto de control
+        std::string discrepancy;                // primera diferencia hallada en un punto de control
+
+        std::thread thread;
+        std::atomic<bool> sleeping{false};
+        std::mutex mutex;
+        std::condition_variable wakeup;
+
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> forwarded{0};
+        std::atomic<uint64_t> recorded{0};
+        std::atomic<uint64_t> checkpoints{0};
+        std::atomic<uint64_t> velocityRejected{0};
+    };
+
+    const Location* locate(const std::string& account) const;
+    void post(Partition& partition, const Command& command);
+    void wake(Partition& partition);
+    void run(size_t index);
+    void handle(Partition& partition, size_t index, const Command& command);
+    void forward(Partition& partition, const Command& command);
+    bool debit(Partition& partition, const Command& command, ExecutionOutcome& outcome);
+    bool flushOutbox(Partition& partition);
+    void record(Partition& partition, char operation, uint32_t slot, double amount, const Transaction* t);
+    void checkpoint(Partition& partition);
+    bool replay(const Partition& partition, std::vector<double>& balances, std::string& difference) const;
+    void auditPartition(const Partition& partition, size_t index, std::string& report) const;
+    ExecutionOutcome submit(size_t partition, Command& command);
+    bool enter();
+    void leave();
+    void failPending(Partition& partition);
+
+    std::unordered_map<std::string, Location> directory;
+    std::vector<std::unique_ptr<Partition>> partitions;
+    VelocityLimits velocityLimits;
+    std::atomic<bool> running;
+    // Llamadores que encolaron (o están por encolar) y esperan su resultado: las
+    // particiones siguen atendiendo mientras haya alguno, aun después de stop()
+    std::atomic<uint64_t> submitters{0};
+};
+
+#endif // SHARD_EXECUTOR_H
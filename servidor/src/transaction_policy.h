@@ -0,0 +1,77 @@
+#ifndef TRANSACTION_POLICY_H
+#define TRANSACTION_POLICY_H
+
+#include <cmath>
+#include "crypto_utils.h"
+#include "metrics.h"
+
+// Reglas de cada tipo de transacción, resueltas en compilación. El servidor arma con
+// ellas su tabla de manejadores (qué cuentas bloquea, qué valida y cómo se cuenta en
+// las métricas): agregar un tipo es agregarlo al enum, especializar esta plantilla y
+// escribir su operación, sin alargar el camino de los tipos existentes.
+template <TransactionType Type>
+struct TransactionPolicy;
+
+template <>
+struct TransactionPolicy<TransactionType::Transfer> {
+    static constexpr bool usesFrom = true;     // lee o debita la cuenta origen
+    static constexpr bool usesTo = true;       // acredita la cuenta destino
+    static constexpr bool movesFunds = true;   // exige un monto positivo
+    static constexpr bool paysService = false; // exige un código de servicio registrado
+    static constexpr bool schedulable = true;  // admite fecha de ejecución futura
+    static constexpr Metrics::TxType metric = Metrics::TxType::Transfer;
+};
+
+template <>
+struct TransactionPolicy<TransactionType::Balance> {
+    static constexpr bool usesFrom = true;
+    static constexpr bool usesTo = false;
+    static constexpr bool movesFunds = false;
+    static constexpr bool paysService = false;
+    static constexpr bool schedulable = false;
+    static constexpr Metrics::TxType metric = Metrics::TxType::Balance;
+};
+
+template <>
+struct TransactionPolicy<TransactionType::Payment> {
+    static constexpr bool usesFrom = true;
+    static constexpr bool usesTo = false;
+    static constexpr bool movesFunds = true;
+    static constexpr bool paysService = true;
+    static constexpr bool schedulable = true;
+    static constexpr Metrics::TxType metric = Metrics::TxType::Payment;
+};
+
+template <>
+struct TransactionPolicy<TransactionType::Deposit> {
+    static constexpr bool usesFrom = false;
+    static constexpr bool usesTo = true;
+    static constexpr bool movesFunds = true;
+    static constexpr bool paysService = false;
+    static constexpr bool schedulable = false;
+    static constexpr Metrics::TxType metric = Metrics::TxType::Deposit;
+};
+
+template <>
+struct TransactionPolicy<TransactionType::Unknown> {
+    static constexpr bool usesFrom = false;
+    static constexpr bool usesTo = false;
+    static constexpr bool movesFunds = false;
+    static constexpr bool paysService = false;
+    static constexpr bool schedulable = false;
+    static constexpr Metrics::TxType metric = Metrics::TxType::Other;
+};
+
+// Validación previa a tocar saldos; nullptr si la transacción es aceptable
+template <TransactionType Type>
+const char* validateTransaction(const Transaction& t) {
+    if constexpr (TransactionPolicy<Type>::movesFunds) {
+        // Un monto negativo invertiría el sentido de la operación
+        if (!std::isfinite(t.amount) || t.amount <= 0.0) {
+            return "ERROR: Monto inválido";
+        }
+    }
+    return nullptr;
+}
+
+#endif // TRANSACTION_POLICY_H
@@ -0,0 +1,237 @@
+#include "transaction_record.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+// Solo minúsculas: con mayúsculas el texto no se podría reproducir igual
+int lowerHexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+bool parseHex(std::string_view text, uint8_t* out) {
+    for (size_t i = 0; i < text.size(); i += 2) {
+        int high = lowerHexValue(text[i]);
+        int low = lowerHexValue(text[i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        out[i / 2] = static_cast<uint8_t>((high << 4) | low);
+    }
+    return true;
+}
+
+void appendHex(const uint8_t* bytes, size_t length, std::string& out) {
+    for (size_t i = 0; i < length; i++) {
+        out.push_back(HEX_DIGITS[bytes[i] >> 4]);
+        out.push_back(HEX_DIGITS[bytes[i] & 0x0f]);
+    }
+}
+
+// xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx en minúsculas
+bool parseUUID(std::string_view text, uint8_t out[16]) {
+    if (text.size() != CryptoUtils::UUID_LENGTH || text[8] != '-' || text[13] != '-' ||
+        text[18] != '-' || text[23] != '-') {
+        return false;
+    }
+    char compact[32];
+    size_t length = 0;
+    for (char c : text) {
+        if (c != '-') {
+            compact[length++] = c;
+        }
+    }
+    return length == 32 && parseHex(std::string_view(compact, length), out);
+}
+
+std::string formatUUID(const uint8_t bytes[16]) {
+    std::string out;
+    out.reserve(CryptoUtils::UUID_LENGTH);
+    for (int i = 0; i < 16; i++) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            out.push_back('-');
+        }
+        appendHex(bytes + i, 1, out);
+    }
+    return out;
+}
+
+// Cuenta numérica: el valor y la cantidad de dígitos (para conservar ceros a la izquierda)
+bool parseAccount(std::string_view text, uint64_t& value, uint8_t& digits) {
+    if (text.size() > 19) {
+        return false;
+    }
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    digits = static_cast<uint8_t>(text.size());
+    return true;
+}
+
+std::string formatAccount(uint64_t value, uint8_t digits) {
+    std::string out(digits, '0');
+    for (size_t i = digits; i > 0 && value > 0; i--) {
+        out[i - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out;
+}
+
+void storeIndex(uint8_t* field, uint32_t index) {
+    memcpy(field, &index, sizeof(index));
+}
+
+uint32_t loadIndex(const uint8_t* field) {
+    uint32_t index;
+    memcpy(&index, field, sizeof(index));
+    return index;
+}
+
+// Devuelve true si el ID no es un UUID y quedó internado en el pool
+bool packId(std::string_view text, uint8_t out[16], StringPool& pool) {
+    if (parseUUID(text, out)) {
+        return false;
+    }
+    memset(out, 0, 16);
+    storeIndex(out, pool.intern(text));
+    return true;
+}
+
+// Centavos exactos: el monto entra en int64_t y dividir por 100 devuelve el mismo double
+bool parseCents(double amount, int64_t& cents) {
+    double scaled = amount * 100.0;
+    if (!std::isfinite(scaled) || std::fabs(scaled) >= 9.0e18) {
+        return false;
+    }
+    cents = std::llround(scaled);
+    return static_cast<double>(cents) / 100.0 == amount;
+}
+
+std::string formatShortest(double amount) {
+    char digits[64];
+    auto end = std::to_chars(digits, digits + sizeof(digits), amount);
+    return std::string(digits, end.ptr - digits);
+}
+
+double parseShortest(const std::string& text) {
+    double amount = 0.0;
+    std::from_chars(text.data(), text.data() + text.size(), amount);
+    return amount;
+}
+
+std::string unpackId(const uint8_t bytes[16], bool interned, const StringPool& pool) {
+    return interned ? pool.lookup(loadIndex(bytes)) : formatUUID(bytes);
+}
+
+} // namespace
+
+uint32_t StringPool::intern(std::string_view value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = indexes.find(value);
+    if (it != indexes.end()) {
+        return it->second;
+    }
+    uint32_t index = static_cast<uint32_t>(values.size());
+    values.emplace_back(value);
+    characters += value.size();
+    indexes.emplace(values.back(), index);
+    return index;
+}
+
+std::string StringPool::lookup(uint32_t index) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index < values.size() ? values[index] : std::string();
+}
+
+size_t StringPool::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return values.size();
+}
+
+void StringPool::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    indexes.clear();
+    values.clear();
+    characters = 0;
+}
+
+size_t StringPool::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return characters + values.size() * (sizeof(std::string) + sizeof(std::string_view) + 3 * sizeof(void*));
+}
+
+TransactionRecord TransactionRecord::pack(const Transaction& t, StringPool& pool) {
+    TransactionRecord record;
+    memset(&record, 0, sizeof(record));
+
+    if (packId(t.id, record.id, pool)) {
+        record.flags |= ID_INTERNED;
+    }
+    if (!CryptoUtils::parseTimestamp(t.timestamp, record.timestampMillis)) {
+        record.flags |= TIMESTAMP_INTERNED;
+        record.timestampMillis = pool.intern(t.timestamp);
+    }
+    if (!parseAccount(t.accountFrom, record.accountFrom, record.fromDigits)) {
+        record.flags |= FROM_INTERNED;
+        record.accountFrom = pool.intern(t.accountFrom);
+    }
+    if (!parseAccount(t.accountTo, record.accountTo, record.toDigits)) {
+        record.flags |= TO_INTERNED;
+        record.accountTo = pool.intern(t.accountTo);
+    }
+    if (t.dynamicToken.size() == sizeof(record.token) * 2 && parseHex(t.dynamicToken, record.token)) {
+        record.flags |= TOKEN_RAW;
+    } else if (!t.dynamicToken.empty()) {
+        memset(record.token, 0, sizeof(record.token));
+        record.flags |= TOKEN_INTERNED;
+        storeIndex(record.token, pool.intern(t.dynamicToken));
+    }
+
+    record.type = t.type;
+    if (!parseCents(t.amount, record.amountCents)) {
+        record.flags |= AMOUNT_INTERNED;
+        record.amountCents = pool.intern(formatShortest(t.amount));
+    }
+    record.serviceCode = pool.intern(t.serviceCode);
+    return record;
+}
+
+Transaction TransactionRecord::unpack(const StringPool& pool) const {
+    Transaction t;
+    t.id = unpackId(id, (flags & ID_INTERNED) != 0, pool);
+    t.timestamp = (flags & TIMESTAMP_INTERNED) ? pool.lookup(static_cast<uint32_t>(timestampMillis))
+                                               : CryptoUtils::formatTimestampMillis(timestampMillis);
+    t.type = type;
+    t.amount = (flags & AMOUNT_INTERNED) ? parseShortest(pool.lookup(static_cast<uint32_t>(amountCents)))
+                                         : static_cast<double>(amountCents) / 100.0;
+    t.accountFrom = (flags & FROM_INTERNED) ? pool.lookup(static_cast<uint32_t>(accountFrom))
+                                            : formatAccount(accountFrom, fromDigits);
+    t.accountTo = (flags & TO_INTERNED) ? pool.lookup(static_cast<uint32_t>(accountTo))
+                                        : formatAccount(accountTo, toDigits);
+    t.serviceCode = pool.lookup(serviceCode);
+    if (flags & TOKEN_RAW) {
+        appendHex(token, sizeof(token), t.dynamicToken);
+    } else if (flags & TOKEN_INTERNED) {
+        t.dynamicToken = pool.lookup(loadIndex(token));
+    }
+    return t;
+}
+
+TransactionIdRecord TransactionIdRecord::pack(std::string_view id, StringPool& pool) {
+    TransactionIdRecord record;
+    record.interned = packId(id, record.bytes, pool);
+    return record;
+}
+
+std::string TransactionIdRecord::unpack(const StringPool& pool) const {
+    return unpackId(bytes, interned, pool);
+}
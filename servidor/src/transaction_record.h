@@ -0,0 +1,87 @@
+#ifndef TRANSACTION_RECORD_H
+#define TRANSACTION_RECORD_H
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <type_traits>
+#include <cstdint>
+#include "crypto_utils.h"
+
+// Tabla de cadenas internadas: cada valor distinto se guarda una sola vez y se
+// referencia por índice. Para códigos de servicio y para los campos que no tienen
+// la forma esperada (IDs que no son UUID, cuentas no numéricas...).
+class StringPool {
+public:
+    uint32_t intern(std::string_view value);
+    std::string lookup(uint32_t index) const;
+    size_t size() const;
+    // Descarta todas las cadenas; los índices entregados dejan de ser válidos
+    void clear();
+    // Bytes aproximados ocupados por las cadenas y el índice
+    size_t memoryBytes() const;
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string_view, uint32_t> indexes; // vistas sobre `values`
+    std::deque<std::string> values;
+    size_t characters = 0;
+};
+
+// Forma compacta de una transacción para almacenamiento interno (historial y
+// registros en disco): tamaño fijo, sin punteros ni memoria dinámica, copiable con
+// memcpy. La conversión desde y hacia Transaction solo ocurre en el borde con el
+// protocolo de texto.
+//   - ID UUID de 36 caracteres -> 16 bytes
+//   - cuentas numéricas de hasta 19 dígitos -> uint64_t y cantidad de dígitos
+//   - token de 64 caracteres hex -> 32 bytes
+//   - timestamp ISO-8601 con milisegundos -> milisegundos desde epoch
+//   - monto con hasta dos decimales -> centavos
+//   - código de servicio -> índice en el StringPool
+// Un campo que no tiene la forma esperada se interna en el StringPool y se marca
+// en `flags`, así que la conversión de vuelta reproduce la transacción original.
+// Un monto que no es un número exacto de centavos o que no entra en int64_t
+// (fracciones de centavo, valores enormes, inf/NaN) se interna como texto con la
+// representación más corta que vuelve al mismo double.
+struct TransactionRecord {
+    static const uint8_t ID_INTERNED = 1 << 0;
+    static const uint8_t TIMESTAMP_INTERNED = 1 << 1;
+    static const uint8_t FROM_INTERNED = 1 << 2;
+    static const uint8_t TO_INTERNED = 1 << 3;
+    static const uint8_t TOKEN_RAW = 1 << 4;
+    static const uint8_t TOKEN_INTERNED = 1 << 5;
+    static const uint8_t AMOUNT_INTERNED = 1 << 6;
+
+    uint8_t id[16];
+    uint8_t token[32];
+    int64_t timestampMillis;
+    uint64_t accountFrom;
+    uint64_t accountTo;
+    int64_t amountCents; // índice en el StringPool si AMOUNT_INTERNED
+    uint32_t serviceCode;
+    TransactionType type;
+    uint8_t flags;
+    uint8_t fromDigits;
+    uint8_t toDigits;
+
+    static TransactionRecord pack(const Transaction& t, StringPool& pool);
+    Transaction unpack(const StringPool& pool) const;
+};
+
+// Solo el ID de una transacción, con la misma codificación que TransactionRecord:
+// un UUID ocupa 16 bytes y cualquier otro texto se interna en el StringPool
+struct TransactionIdRecord {
+    uint8_t bytes[16];
+    bool interned;
+
+    static TransactionIdRecord pack(std::string_view id, StringPool& pool);
+    std::string unpack(const StringPool& pool) const;
+};
+
+static_assert(std::is_trivially_copyable<TransactionRecord>::value,
+              "TransactionRecord debe poder copiarse con memcpy");
+static_assert(sizeof(TransactionRecord) == 88, "TransactionRecord cambió de tamaño");
+
+#endif // TRANSACTION_RECORD_H
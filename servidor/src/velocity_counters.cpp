@@ -0,0 +1,127 @@
+#include "velocity_counters.h"
+#include <chrono>
+#include <sstream>
+
+namespace {
+
+const char* const WINDOW_NAMES[VelocityLimits::WINDOWS] = {"minuto", "hora", "día"};
+
+const char* const WINDOW_ERRORS[VelocityLimits::WINDOWS] = {
+    "ERROR: Límite de velocidad excedido (minuto)",
+    "ERROR: Límite de velocidad excedido (hora)",
+    "ERROR: Límite de velocidad excedido (día)"
+};
+
+uint64_t slotMillis(size_t window) {
+    return VelocityLimits::WINDOW_MILLIS[window] / (VelocityCounters::SLOTS - 1);
+}
+
+} // namespace
+
+const uint64_t VelocityLimits::WINDOW_MILLIS[VelocityLimits::WINDOWS] = {
+    60ULL * 1000, 3600ULL * 1000, 86400ULL * 1000
+};
+
+bool VelocityLimits::enabled() const {
+    for (size_t w = 0; w < WINDOWS; w++) {
+        if (maxCount[w] > 0 || maxAmount[w] > 0.0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* VelocityLimits::error(size_t window) {
+    return WINDOW_ERRORS[window];
+}
+
+std::string VelocityLimits::describe() const {
+    if (!enabled()) {
+        return "sin límites";
+    }
+    std::stringstream ss;
+    const char* separator = "";
+    for (size_t w = 0; w < WINDOWS; w++) {
+        if (maxCount[w] == 0 && maxAmount[w] <= 0.0) {
+            continue;
+        }
+        ss << separator << WINDOW_NAMES[w] << ": ";
+        if (maxCount[w] > 0) {
+            ss << maxCount[w] << " débitos" << (maxAmount[w] > 0.0 ? " y " : "");
+        }
+        if (maxAmount[w] > 0.0) {
+            ss << "$" << maxAmount[w];
+        }
+        separator = "; ";
+    }
+    return ss.str();
+}
+
+uint64_t VelocityCounters::nowMillis() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Vacía los casilleros de los períodos que pasaron desde el último movimiento. Un
+// `now` algo anterior al último registrado (otro hilo lo tomó antes del lock) se
+// cuenta en el período actual.
+void VelocityCounters::advance(size_t window, uint64_t now) {
+    Window& w = windows[window];
+    uint32_t period = static_cast<uint32_t>(now / slotMillis(window));
+    if (period <= w.period) {
+        return;
+    }
+    uint32_t elapsed = period - w.period;
+    for (uint32_t i = 1; i <= elapsed && i <= SLOTS; i++) {
+        size_t slot = (w.period + i) % SLOTS;
+        w.counts[slot] = 0;
+        w.amounts[slot] = 0.0f;
+    }
+    w.period = period;
+}
+
+void VelocityCounters::estimate(size_t window, uint64_t now, double& count, double& amount) const {
+    const Window& w = windows[window];
+    uint64_t width = slotMillis(window);
+    double elapsed = now / width == w.period ? static_cast<double>(now % width) / width : 1.0;
+    // El casillero siguiente al actual en el anillo es el más viejo
+    size_t oldest = (w.period + 1) % SLOTS;
+    count = 0.0;
+    amount = 0.0;
+    for (size_t slot = 0; slot < SLOTS; slot++) {
+        double weight = slot == oldest ? 1.0 - elapsed : 1.0;
+        count += w.counts[slot] * weight;
+        amount += w.amounts[slot] * weight;
+    }
+}
+
+int VelocityCounters::exceeded(uint64_t now, double amount, const VelocityLimits& limits) {
+    for (size_t w = 0; w < WINDOWS; w++) {
+        if (limits.maxCount[w] == 0 && limits.maxAmount[w] <= 0.0) {
+            continue;
+        }
+        advance(w, now);
+        double count;
+        double total;
+        estimate(w, now, count, total);
+        if (limits.maxCount[w] > 0 && count + 1.0 > limits.maxCount[w]) {
+            return static_cast<int>(w);
+        }
+        if (limits.maxAmount[w] > 0.0 && total + amount > limits.maxAmount[w]) {
+            return static_cast<int>(w);
+        }
+    }
+    return -1;
+}
+
+void VelocityCounters::record(uint64_t now, double amount) {
+    for (size_t w = 0; w < WINDOWS; w++) {
+        advance(w, now);
+        Window& window = windows[w];
+        size_t slot = window.period % SLOTS;
+        if (window.counts[slot] < UINT16_MAX) {
+            window.counts[slot]++;
+        }
+        window.amounts[slot] += static_cast<float>(amount);
+    }
+}
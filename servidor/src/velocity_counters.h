@@ -0,0 +1,60 @@
+#ifndef VELOCITY_COUNTERS_H
+#define VELOCITY_COUNTERS_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Límites de velocidad por cuenta sobre los débitos (transferencias salientes y
+// pagos): cantidad y suma en las ventanas de un minuto, una hora y un día. 0 = sin límite.
+struct VelocityLimits {
+    static const size_t WINDOWS = 3;
+    static const uint64_t WINDOW_MILLIS[WINDOWS];
+
+    uint32_t maxCount[WINDOWS] = {0, 0, 0};
+    double maxAmount[WINDOWS] = {0.0, 0.0, 0.0};
+
+    bool enabled() const;
+    // Texto de la respuesta cuando se supera un límite de la ventana
+    static const char* error(size_t window);
+    std::string describe() const;
+};
+
+// Contadores de débitos de una cuenta, en línea con su saldo y protegidos por el
+// mismo lock que lo protege (el del fragmento, las franjas de una cuenta dividida o
+// el hilo de la partición del ledger). Por ventana, un anillo de 4 casilleros de un
+// tercio de la ventana: los tres más recientes cuentan completos y el más viejo en
+// proporción a la parte que todavía cae dentro, una aproximación de ventana
+// deslizante. Cantidades saturadas en 65535 y sumas en float: 84 bytes por cuenta.
+class VelocityCounters {
+public:
+    static const size_t WINDOWS = VelocityLimits::WINDOWS;
+    static const size_t SLOTS = 4;
+
+    // Ventana cuyo límite superaría un débito de `amount` en `now`, o -1 si ninguna
+    int exceeded(uint64_t now, double amount, const VelocityLimits& limits);
+    // Registra un débito ya aplicado
+    void record(uint64_t now, double amount);
+
+    // Milisegundos de un reloj monótono
+    static uint64_t nowMillis();
+
+private:
+    struct Window {
+        uint32_t period;
+        uint16_t counts[SLOTS];
+        float amounts[SLOTS];
+    };
+
+    void advance(size_t window, uint64_t now);
+    void estimate(size_t window, uint64_t now, double& count, double& amount) const;
+
+    Window windows[WINDOWS] = {};
+};
+
+static_assert(std::is_trivially_copyable<VelocityCounters>::value,
+              "VelocityCounters se copia para revertir lotes atómicos");
+static_assert(sizeof(VelocityCounters) == 84, "VelocityCounters cambió de tamaño");
+
+#endif // VELOCITY_COUNTERS_H
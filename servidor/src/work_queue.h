@@ -0,0 +1,73 @@
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstddef>
+
+// Cola acotada multi-productor/multi-consumidor. tryPush nunca bloquea: si la
+// cola está llena el llamador debe rechazar el trabajo (load shedding).
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity), closed(false), depth(0) {}
+
+    bool tryPush(T item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closed || items.size() >= capacity) {
+                return false;
+            }
+            items.push_back(std::move(item));
+            depth.store(items.size(), std::memory_order_relaxed);
+        }
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Bloquea hasta obtener elementos; devuelve false si la cola se cerró y está
+    // vacía. Si hay al menos `batchDepth` elementos en espera toma hasta
+    // `maxItems` de una vez. Con la cola poco profunda devuelve uno solo para no
+    // acaparar trabajo que otro hilo libre podría atender en paralelo.
+    bool popBatch(std::vector<T>& batch, size_t maxItems, size_t batchDepth) {
+        batch.clear();
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+        if (items.empty()) {
+            return false;
+        }
+        size_t take = items.size() >= batchDepth ? std::min(maxItems, items.size()) : 1;
+        for (size_t i = 0; i < take; i++) {
+            batch.push_back(std::move(items.front()));
+            items.pop_front();
+        }
+        depth.store(items.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        notEmpty.notify_all();
+    }
+
+    // Lectura sin lock para métricas y estado
+    size_t size() const { return depth.load(std::memory_order_relaxed); }
+    size_t maxSize() const { return capacity; }
+
+private:
+    const size_t capacity;
+    bool closed;
+    std::atomic<size_t> depth;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+};
+
+#endif // WORK_QUEUE_H